@@ -0,0 +1,263 @@
+/*
+ * bench.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Benchmark suite of the backend the library was built with, the results are printed as CSV, or
+ * as JSON with --json
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "siphash.h"
+#include "siphash_batch.h"
+#include "kdf1.h"
+#include "zkdf1.h"
+
+#define MAXLEN 4096
+#define BATCH 64
+
+/* Minimal time of a single measurement, in clock ticks. */
+#define MIN_TICKS (CLOCKS_PER_SEC / 50)
+#define RUNS 3
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define _BENCH_TSC
+#endif
+
+static const size_t lengths[] = {
+    0, 1, 3, 7, 8, 15, 16, 24, 31, 32, 48, 63, 64, 128, 256, 512, 1024, 2048, 4096
+};
+
+/* kdf1 output is limited to 1023 bytes, zkdf1 continues up to MAXLEN. */
+static const size_t kdf_lengths[] = {8, 16, 32, 64, 128, 256, 512, 1016, 4096};
+
+static const char *isa_names[] = {"scalar", "sse2", "avx2", "avx512"};
+
+/* Aligned to 8 bytes, so an offset of 1 gives an unaligned input. */
+static union {
+    uint64_t align;
+    uint8_t bytes[MAXLEN + BATCH + 8];
+} buffer;
+
+static uint8_t *data, key[16], out[MAXLEN];
+static const uint8_t *datas[BATCH];
+static size_t lens[BATCH];
+static siphash_key_t prepared;
+
+static int json = 0, rows = 0;
+
+typedef struct {
+    double ns;
+    double cycles;
+} bench_result;
+
+#ifdef _BENCH_TSC
+static double rdtsc() {
+    uint32_t lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+    return hi * 4294967296.0 + lo;
+}
+#endif
+
+/* Each of the functions below returns the number of operations performed. */
+
+static int hash_oneshot(const size_t len) {
+    siphash(out, data, len, key);
+    return 1;
+}
+
+static int hash_prepared(const size_t len) {
+    siphash_with_key(out, data, len, &prepared);
+    return 1;
+}
+
+/* The fixed length entry point for len, len being 4, 8 or 16. */
+static int hash_fixed(const size_t len) {
+    if (len == 4) siphash_u32(out, data, &prepared);
+    else if (len == 8) siphash_u64(out, data, &prepared);
+    else siphash_u128(out, data, &prepared);
+    return 1;
+}
+
+static int hash_batch(const size_t len) {
+    size_t i;
+    for (i = 0; i < BATCH; i++) lens[i] = len;
+    siphash_batch(out, datas, lens, BATCH, key);
+    return BATCH;
+}
+
+static int derive(const size_t len) {
+    kdf1(out, len, data, 32, key);
+    return 1;
+}
+
+static int derive_zkdf1(const size_t len) {
+    zkdf1(out, len, data, 32, key);
+    return 1;
+}
+
+/*
+ * Measures the average time of a single operation in nanoseconds and, where available, in TSC cycles.
+ * The best out of RUNS measurements is taken to filter out the noise of other processes.
+ */
+static bench_result measure(int (*fn)(const size_t), const size_t len) {
+    
+    unsigned long ops, n, j;
+    clock_t start, elapsed;
+    bench_result result, best;
+    int run;
+#ifdef _BENCH_TSC
+    double cycles;
+#endif
+    
+    best.ns = best.cycles = 0;
+    
+    for (run = 0; run < RUNS; run++) {
+        
+        ops = 0;
+        n = 16;
+        start = clock();
+#ifdef _BENCH_TSC
+        cycles = rdtsc();
+#endif
+        
+        /* Double the batch until the measurement takes long enough. */
+        do {
+            for (j = 0; j < n; j++) {
+                ops += fn(len);
+                /* Chain the result so the calls can't be optimized out. */
+                data[0] ^= out[0];
+            }
+            n *= 2;
+            elapsed = clock() - start;
+        } while (elapsed < MIN_TICKS);
+        
+#ifdef _BENCH_TSC
+        result.cycles = (rdtsc() - cycles) / ops;
+#else
+        result.cycles = 0;
+#endif
+        result.ns = (double) elapsed / CLOCKS_PER_SEC * 1e9 / ops;
+        if (run == 0 || result.ns < best.ns) best = result;
+        
+    }
+    
+    return best;
+    
+}
+
+/*
+ * One row per measurement. An operation is a single hash, bytes being its input length, except for
+ * the KDFs where it is a single derivation, bytes being the derived key length. Cycles are left empty
+ * if the timestamp counter is not available.
+ */
+static void report(const char *benchmark, const char *variant, const size_t len, const bench_result r) {
+    
+    if (json) {
+        printf("%s\n  {\"backend\": %d, \"benchmark\": \"%s\", \"variant\": \"%s\", \"bytes\": %lu, "
+            "\"ns_per_op\": %.2f, \"ops_per_sec\": %.0f, \"mb_per_sec\": %.2f, ",
+            rows ? "," : "[", MSH_BACKEND, benchmark, variant, (unsigned long) len, r.ns, 1e9 / r.ns,
+            len * 1e3 / r.ns);
+        if (r.cycles) {
+            printf("\"cycles_per_op\": %.1f, ", r.cycles);
+            if (len) printf("\"cycles_per_byte\": %.3f}", r.cycles / len);
+            else printf("\"cycles_per_byte\": null}");
+        } else {
+            printf("\"cycles_per_op\": null, \"cycles_per_byte\": null}");
+        }
+    } else {
+        if (!rows) {
+            printf("backend,benchmark,variant,bytes,ns_per_op,ops_per_sec,mb_per_sec,"
+                "cycles_per_op,cycles_per_byte\n");
+        }
+        printf("%d,%s,%s,%lu,%.2f,%.0f,%.2f,", MSH_BACKEND, benchmark, variant, (unsigned long) len,
+            r.ns, 1e9 / r.ns, len * 1e3 / r.ns);
+        if (r.cycles) printf("%.1f,", r.cycles);
+        else printf(",");
+        if (r.cycles && len) printf("%.3f\n", r.cycles / len);
+        else printf("\n");
+    }
+    
+    rows++;
+    fflush(stdout);
+    
+}
+
+int main(int argc, char **argv) {
+    
+    size_t i, len;
+    int isa;
+    
+    json = argc > 1 && !strcmp(argv[1], "--json");
+    
+    for (i = 0; i < 16; i++) key[i] = (uint8_t) i;
+    for (i = 0; i < sizeof(buffer.bytes); i++) buffer.bytes[i] = (uint8_t) i;
+    
+    siphash_key_init(&prepared, key);
+    
+    for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        len = lengths[i];
+        data = buffer.bytes;
+        report("siphash", "aligned", len, measure(hash_oneshot, len));
+        data = buffer.bytes + 1;
+        report("siphash", "unaligned", len, measure(hash_oneshot, len));
+        data = buffer.bytes;
+        report("siphash_with_key", "aligned", len, measure(hash_prepared, len));
+    }
+    
+    /* Integer and UUID sized keys, the generic code against the unrolled one. */
+    data = buffer.bytes;
+    for (len = 4; len <= 16; len *= 2) {
+        report("siphash_fixed", "generic", len, measure(hash_prepared, len));
+        report("siphash_fixed", "unrolled", len, measure(hash_fixed, len));
+    }
+    
+    /* Every message of the batch starts at a different alignment. */
+    for (i = 0; i < BATCH; i++) datas[i] = buffer.bytes + i % 8;
+    
+    for (isa = SIPHASH_BATCH_SCALAR; isa <= SIPHASH_BATCH_AVX512; isa++) {
+        if (siphash_batch_select(isa) != isa) continue;
+        for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+            report("siphash_batch", isa_names[isa], lengths[i], measure(hash_batch, lengths[i]));
+        }
+    }
+    
+    siphash_batch_select(SIPHASH_BATCH_AUTO);
+    
+    /* Derivations from 32 bytes of info. */
+    data = buffer.bytes;
+    for (i = 0; i < sizeof(kdf_lengths) / sizeof(kdf_lengths[0]); i++) {
+        if (kdf_lengths[i] <= 1023) {
+            report("kdf1", "info32", kdf_lengths[i], measure(derive, kdf_lengths[i]));
+        }
+        report("zkdf1", "info32", kdf_lengths[i], measure(derive_zkdf1, kdf_lengths[i]));
+    }
+    
+    if (json) printf("\n]\n");
+    
+    return 0;
+    
+}
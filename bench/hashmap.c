@@ -0,0 +1,112 @@
+/*
+ * hashmap.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Throughput of the hash map with SipHash compared to a non-keyed hash
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "hashmap.h"
+
+#define KEYS 200000
+#define KEY_LEN 16
+#define RUNS 5
+
+static uint8_t keys[KEYS][KEY_LEN];
+
+static void siphash13_hash(uint8_t *hash, const uint8_t *data, const size_t len, const siphash_key_t *key) {
+    siphash13_with_key(hash, data, len, key);
+}
+
+static void fnv1a_hash(uint8_t *hash, const uint8_t *data, const size_t len, const siphash_key_t *key) {
+    uint32_t h = 2166136261UL;
+    size_t i;
+    (void) key;
+    for (i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 16777619UL;
+    }
+    hash[0] = (uint8_t) h;
+    hash[1] = (uint8_t) (h >> 8);
+    hash[2] = (uint8_t) (h >> 16);
+    hash[3] = (uint8_t) (h >> 24);
+    hash[4] = (uint8_t) (h >> 25);
+}
+
+/*
+ * Returns the number of operations per second of inserting all the keys into an empty map and
+ * looking all of them up, the best out of RUNS measurements.
+ */
+static double measure(msh_map_hash_fn hash) {
+    
+    msh_map map;
+    clock_t start, elapsed;
+    double ops, best = 0;
+    size_t i, found;
+    int run;
+    
+    for (run = 0; run < RUNS; run++) {
+        
+        if (msh_map_init(&map, 0, msh_map_urandom)) return 0;
+        map.hash = hash;
+        found = 0;
+        
+        start = clock();
+        for (i = 0; i < KEYS; i++) msh_map_insert(&map, keys[i], KEY_LEN, NULL);
+        for (i = 0; i < KEYS; i++) found += msh_map_find(&map, keys[i], KEY_LEN) != NULL;
+        elapsed = clock() - start;
+        
+        msh_map_free(&map);
+        if (found != KEYS) return 0;
+        
+        ops = 2.0 * KEYS * CLOCKS_PER_SEC / (elapsed ? elapsed : 1);
+        if (ops > best) best = ops;
+        
+    }
+    
+    return best;
+    
+}
+
+int main() {
+    
+    size_t i, j;
+    
+    srand(1);
+    for (i = 0; i < KEYS; i++) {
+        for (j = 0; j < KEY_LEN; j++) keys[i][j] = (uint8_t) rand();
+    }
+    
+    printf("hash map, %d-bit backend, %d keys of %d bytes\n", MSH_BACKEND, KEYS, KEY_LEN);
+    printf("%-12s %12s\n", "hash", "Mops/s");
+    printf("%-12s %12.2f\n", "siphash", measure(siphash_with_key) / 1e6);
+    printf("%-12s %12.2f\n", "siphash13", measure(siphash13_hash) / 1e6);
+    printf("%-12s %12.2f\n", "fnv1a", measure(fnv1a_hash) / 1e6);
+    
+    return 0;
+    
+}
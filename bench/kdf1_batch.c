@@ -0,0 +1,138 @@
+/*
+ * kdf1_batch.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Throughput of the batched kdf1 of extras/fkdf1 in derived keys per second, printed as CSV
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <time.h>
+#include "fkdf1.h"
+#include "siphash_batch.h"
+
+#define N 4096
+#define KEY_LEN 32
+#define RUNS 5
+#define MIN_TIME 0.05
+#define MAX_THREADS 8
+
+static const char *names[] = {"scalar", "sse2", "avx2", "avx512"};
+
+static uint8_t key_pool[N][16], info_pool[N][KDF_INFO_LEN], scratch[KDF_BATCH_SCRATCH(N)];
+static uint8_t derived[N * KEY_LEN];
+static const uint8_t *keys[N], *infos[N];
+static size_t info_lens[N];
+static msh_pool pool;
+
+static void derive_serial(void) {
+    size_t i;
+    for (i = 0; i < N; i++) kdf1(derived + i * KEY_LEN, KEY_LEN, infos[i], info_lens[i], keys[i]);
+}
+
+static void derive_batch(void) {
+    kdf1_batch(derived, KEY_LEN, infos, info_lens, keys, N, scratch);
+}
+
+static void derive_parallel(void) {
+    kdf1_batch_parallel(derived, KEY_LEN, infos, info_lens, keys, N, scratch, &pool);
+}
+
+/* Wall clock time in seconds, as CPU time would add up across the threads. */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Derived keys per second, the best out of RUNS measurements of at least MIN_TIME seconds.
+ */
+static double measure(void (*fn)(void)) {
+    
+    unsigned long n;
+    double start, elapsed, rate, best = 0;
+    int run;
+    
+    for (run = 0; run < RUNS; run++) {
+        n = 0;
+        start = now();
+        do {
+            fn();
+            n++;
+            elapsed = now() - start;
+        } while (elapsed < MIN_TIME);
+        rate = n * N / elapsed;
+        if (rate > best) best = rate;
+    }
+    
+    return best;
+    
+}
+
+static void report(const char *variant, const int threads, const double rate) {
+    printf("%d,kdf1,%s,%d,%d,%.0f\n", MSH_BACKEND, variant, threads, KEY_LEN, rate);
+    fflush(stdout);
+}
+
+int main() {
+    
+    char variant[32];
+    size_t i, j;
+    int isa, threads;
+    
+    srand(1);
+    
+    for (i = 0; i < N; i++) {
+        for (j = 0; j < 16; j++) key_pool[i][j] = (uint8_t) rand();
+        for (j = 0; j < KDF_INFO_LEN; j++) info_pool[i][j] = (uint8_t) rand();
+        keys[i] = key_pool[i];
+        infos[i] = info_pool[i];
+        info_lens[i] = KDF_INFO_LEN;
+    }
+    
+    printf("backend,benchmark,variant,threads,bytes,keys_per_sec\n");
+    
+    report("serial", 1, measure(derive_serial));
+    
+    for (isa = SIPHASH_BATCH_SCALAR; isa <= SIPHASH_BATCH_AVX512; isa++) {
+        if (siphash_batch_select(isa) != isa) continue;
+        sprintf(variant, "batch_%s", names[isa]);
+        report(variant, 1, measure(derive_batch));
+    }
+    
+    siphash_batch_select(SIPHASH_BATCH_AUTO);
+    
+    for (threads = 2; threads <= MAX_THREADS && threads <= 2 * msh_pool_cpus(); threads *= 2) {
+        if (msh_pool_init(&pool, threads)) return 1;
+        report("batch_parallel", threads, measure(derive_parallel));
+        msh_pool_free(&pool);
+    }
+    
+    return 0;
+    
+}
@@ -0,0 +1,205 @@
+/*
+ * keystore.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Benchmark of hashing a short item under a key being rotated, at 1 to 64 threads: the key pinned
+ * through the key store, copied under a mutex, and a fixed key with no rotation support at all
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "keystore.h"
+
+#define ITEM_LEN 16
+#define LOOKUPS 200000
+#define MAX_THREADS 64
+#define RUNS 3
+/* Rotation period of the writer thread, in microseconds. */
+#define ROTATE_US 1000
+
+static msh_keystore store;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static siphash_key_t locked, fixed;
+static int stop;
+static uint64_t sinks[MAX_THREADS];
+
+static uint64_t hash_item(const uint8_t *item, const siphash_key_t *key) {
+    uint8_t hash[8];
+    siphash_with_key(hash, item, ITEM_LEN, key);
+    return (uint64_t) hash[0] | (uint64_t) hash[7] << 56;
+}
+
+static void *lookup_keystore(void *arg) {
+    
+    int id = *(int *) arg;
+    msh_keystore_reader *r = msh_keystore_register(&store);
+    const msh_keyset *keys;
+    uint8_t item[ITEM_LEN];
+    unsigned long i;
+    
+    memset(item, id, sizeof(item));
+    for (i = 0; i < LOOKUPS; i++) {
+        item[0] = (uint8_t) i;
+        keys = msh_keystore_enter(&store, r);
+        sinks[id] += hash_item(item, &keys->current);
+        msh_keystore_exit(r);
+    }
+    msh_keystore_unregister(r);
+    
+    return NULL;
+    
+}
+
+static void *lookup_mutex(void *arg) {
+    
+    int id = *(int *) arg;
+    siphash_key_t key;
+    uint8_t item[ITEM_LEN];
+    unsigned long i;
+    
+    memset(item, id, sizeof(item));
+    for (i = 0; i < LOOKUPS; i++) {
+        item[0] = (uint8_t) i;
+        pthread_mutex_lock(&lock);
+        key = locked;
+        pthread_mutex_unlock(&lock);
+        sinks[id] += hash_item(item, &key);
+    }
+    
+    return NULL;
+    
+}
+
+static void *lookup_fixed(void *arg) {
+    
+    int id = *(int *) arg;
+    uint8_t item[ITEM_LEN];
+    unsigned long i;
+    
+    memset(item, id, sizeof(item));
+    for (i = 0; i < LOOKUPS; i++) {
+        item[0] = (uint8_t) i;
+        sinks[id] += hash_item(item, &fixed);
+    }
+    
+    return NULL;
+    
+}
+
+/* Rotates the key of both the key store and the mutex variant. */
+static void *rotator(void *arg) {
+    
+    struct timespec period;
+    uint8_t key[16];
+    unsigned long n = 0;
+    
+    (void) arg;
+    period.tv_sec = 0;
+    period.tv_nsec = ROTATE_US * 1000L;
+    
+    while (!__atomic_load_n(&stop, __ATOMIC_SEQ_CST)) {
+        memset(key, (uint8_t) ++n, sizeof(key));
+        msh_keystore_rotate(&store, key);
+        pthread_mutex_lock(&lock);
+        siphash_key_init(&locked, key);
+        pthread_mutex_unlock(&lock);
+        nanosleep(&period, NULL);
+    }
+    
+    return NULL;
+    
+}
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec * 1e9 + (double) t.tv_nsec;
+}
+
+/*
+ * Returns the wall time per lookup over all the threads in nanoseconds, the best out of RUNS
+ * measurements.
+ */
+static double measure(void *(*lookup)(void *), const int threads) {
+    
+    pthread_t workers[MAX_THREADS], writer;
+    int ids[MAX_THREADS], i, run;
+    double start, ns, best = 0;
+    
+    for (run = 0; run < RUNS; run++) {
+        
+        __atomic_store_n(&stop, 0, __ATOMIC_SEQ_CST);
+        if (pthread_create(&writer, NULL, rotator, NULL)) exit(1);
+        
+        start = now();
+        for (i = 0; i < threads; i++) {
+            ids[i] = i;
+            if (pthread_create(&workers[i], NULL, lookup, &ids[i])) exit(1);
+        }
+        for (i = 0; i < threads; i++) pthread_join(workers[i], NULL);
+        ns = (now() - start) / ((double) LOOKUPS * threads);
+        
+        __atomic_store_n(&stop, 1, __ATOMIC_SEQ_CST);
+        pthread_join(writer, NULL);
+        
+        if (run == 0 || ns < best) best = ns;
+        
+    }
+    
+    return best;
+    
+}
+
+int main() {
+    
+    uint8_t key[16];
+    uint64_t sink = 0;
+    int threads, i;
+    
+    memset(key, 0, sizeof(key));
+    if (msh_keystore_init(&store, key)) return 1;
+    siphash_key_init(&locked, key);
+    siphash_key_init(&fixed, key);
+    
+    printf("backend,benchmark,threads,ns_per_lookup\n");
+    for (threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        printf("%d,keystore,%d,%.1f\n", MSH_BACKEND, threads, measure(lookup_keystore, threads));
+        printf("%d,mutex,%d,%.1f\n", MSH_BACKEND, threads, measure(lookup_mutex, threads));
+        printf("%d,fixed_key,%d,%.1f\n", MSH_BACKEND, threads, measure(lookup_fixed, threads));
+        fflush(stdout);
+    }
+    
+    msh_keystore_free(&store);
+    for (i = 0; i < MAX_THREADS; i++) sink += sinks[i];
+    
+    return (int) (sink & 0);
+    
+}
@@ -0,0 +1,204 @@
+/*
+ * mac.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Benchmark of the packets per second signed and verified at 64, 512 and 1500 byte frames, batched
+ * against a loop of siphash_with_key() and memcmp(), and end to end over loopback UDP
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "mac.h"
+
+#define RING 1024
+#define BURST 64
+#define MAX_FRAME 1500
+#define RUNS 3
+
+/* Minimal time of a single measurement, in seconds. */
+#define MIN_TIME 0.1
+
+static uint8_t *frames, key[16], bitmap[RING / 8];
+static siphash_mac_desc ring[RING];
+static siphash_key_t prepared;
+static int rx, tx;
+static struct sockaddr_in addr;
+static unsigned long sink;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Each of the functions below processes the whole ring and returns the number of packets. */
+
+static size_t sign_loop(void) {
+    size_t i;
+    for (i = 0; i < RING; i++) {
+        siphash_with_key(ring[i].data + ring[i].tag_off, ring[i].data, ring[i].len, &prepared);
+    }
+    return RING;
+}
+
+static size_t verify_loop(void) {
+    uint8_t tag[8];
+    size_t i;
+    for (i = 0; i < RING; i++) {
+        siphash_with_key(tag, ring[i].data, ring[i].len, &prepared);
+        sink += !memcmp(tag, ring[i].data + ring[i].tag_off, 8);
+    }
+    return RING;
+}
+
+static size_t sign_batch(void) {
+    siphash_mac_sign_batch(ring, RING, 0, RING, key);
+    return RING;
+}
+
+static size_t verify_batch(void) {
+    sink += siphash_mac_verify_batch(ring, RING, 0, RING, key, bitmap);
+    return RING;
+}
+
+/* Send a burst of the signed frames to ourselves, receive it back into the ring and verify it. */
+static size_t udp_loopback(void) {
+    
+    size_t i, frame = ring[0].len + SIPHASH_MAC_TAG;
+    
+    for (i = 0; i < BURST; i++) {
+        sendto(tx, ring[i].data, frame, 0, (struct sockaddr *) &addr, sizeof(addr));
+    }
+    for (i = 0; i < BURST; i++) {
+        if (recv(rx, ring[i].data, frame, 0) != (ssize_t) frame) return 0;
+    }
+    sink += siphash_mac_verify_batch(ring, RING, 0, BURST, key, bitmap);
+    
+    return BURST;
+    
+}
+
+/*
+ * Returns the packets per second, the best out of RUNS measurements.
+ */
+static double measure(size_t (*fn)(void)) {
+    
+    double start, elapsed, rate, best = 0;
+    unsigned long packets;
+    size_t done;
+    int run;
+    
+    for (run = 0; run < RUNS; run++) {
+        packets = 0;
+        start = now();
+        do {
+            done = fn();
+            if (!done) return 0;
+            packets += done;
+            elapsed = now() - start;
+        } while (elapsed < MIN_TIME);
+        rate = packets / elapsed;
+        if (rate > best) best = rate;
+    }
+    
+    return best;
+    
+}
+
+static int udp_open(void) {
+    
+    socklen_t addr_len = sizeof(addr);
+    int size = 4 << 20;
+    
+    rx = socket(AF_INET, SOCK_DGRAM, 0);
+    tx = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    
+    if (rx < 0 || tx < 0 || bind(rx, (struct sockaddr *) &addr, sizeof(addr)) ||
+        getsockname(rx, (struct sockaddr *) &addr, &addr_len)) {
+        return -1;
+    }
+    
+    setsockopt(rx, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    
+    return 0;
+    
+}
+
+int main() {
+    
+    static const size_t sizes[] = {64, 512, 1500};
+    size_t i, s;
+    int udp;
+    
+    frames = malloc((size_t) RING * MAX_FRAME);
+    srand(1);
+    for (i = 0; i < 16; i++) key[i] = (uint8_t) rand();
+    for (i = 0; i < (size_t) RING * MAX_FRAME; i++) frames[i] = (uint8_t) rand();
+    siphash_key_init(&prepared, key);
+    
+    udp = !udp_open();
+    
+    printf("backend,benchmark,variant,frame,packets_per_sec\n");
+    
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        
+        /* Frames of the given size, the tag trailing the payload. */
+        for (i = 0; i < RING; i++) {
+            ring[i].data = frames + i * MAX_FRAME;
+            ring[i].len = sizes[s] - SIPHASH_MAC_TAG;
+            ring[i].tag_off = ring[i].len;
+        }
+        
+        printf("%d,sign,loop,%lu,%.0f\n", MSH_BACKEND, (unsigned long) sizes[s], measure(sign_loop));
+        printf("%d,sign,batch,%lu,%.0f\n", MSH_BACKEND, (unsigned long) sizes[s], measure(sign_batch));
+        printf("%d,verify,loop,%lu,%.0f\n", MSH_BACKEND, (unsigned long) sizes[s], measure(verify_loop));
+        printf("%d,verify,batch,%lu,%.0f\n", MSH_BACKEND, (unsigned long) sizes[s], measure(verify_batch));
+        if (udp) {
+            printf("%d,verify,udp_loopback,%lu,%.0f\n", MSH_BACKEND, (unsigned long) sizes[s],
+                measure(udp_loopback));
+        }
+        fflush(stdout);
+        
+    }
+    
+    if (udp) {
+        close(rx);
+        close(tx);
+    }
+    
+    return (int) (sink & 0);
+    
+}
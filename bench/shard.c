@@ -0,0 +1,135 @@
+/*
+ * shard.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Benchmark of routing an item to one of 16 to 4096 nodes: jump consistent hashing, rendezvous
+ * hashing over the prepared node keys, and rendezvous hashing by full siphash() calls
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "shard.h"
+
+#define ITEMS 1024
+#define ITEM_LEN 16
+#define MAX_NODES 4096
+#define RUNS 3
+
+/* Minimal time of a single measurement, in clock ticks. */
+#define MIN_TICKS (CLOCKS_PER_SEC / 20)
+
+static uint8_t items[ITEMS][ITEM_LEN], key[16];
+static siphash_key_t prepared;
+static msh_hrw hrw;
+static int32_t nodes;
+static uint64_t sink;
+
+static void route_jump(const uint8_t *item) {
+    sink += (uint64_t) msh_jump(item, ITEM_LEN, &prepared, nodes);
+}
+
+static void route_hrw(const uint8_t *item) {
+    uint64_t id;
+    msh_hrw_route(&hrw, item, ITEM_LEN, &id);
+    sink += id;
+}
+
+/* The weight of a node being the hash of its id followed by the item, under the routing key. */
+static void route_naive(const uint8_t *item) {
+    
+    uint8_t buf[8 + ITEM_LEN], weight[8];
+    uint64_t w, best = 0, winner = 0;
+    int32_t i;
+    int j;
+    
+    memcpy(buf + 8, item, ITEM_LEN);
+    for (i = 0; i < nodes; i++) {
+        for (j = 0; j < 8; j++) buf[j] = (uint8_t) ((uint32_t) i >> (8 * (j % 4)));
+        siphash(weight, buf, sizeof(buf), key);
+        for (w = 0, j = 7; j >= 0; j--) w = (w << 8) | weight[j];
+        if (i == 0 || w > best) {
+            best = w;
+            winner = (uint64_t) i;
+        }
+    }
+    
+    sink += winner;
+    
+}
+
+/*
+ * Returns the time of a single route in nanoseconds, the best out of RUNS measurements.
+ */
+static double measure(void (*route)(const uint8_t *)) {
+    
+    unsigned long ops, i;
+    clock_t start, elapsed;
+    double ns, best = 0;
+    int run;
+    
+    for (run = 0; run < RUNS; run++) {
+        ops = 0;
+        start = clock();
+        do {
+            for (i = 0; i < ITEMS; i++) route(items[i]);
+            ops += ITEMS;
+            elapsed = clock() - start;
+        } while (elapsed < MIN_TICKS);
+        ns = (double) elapsed / CLOCKS_PER_SEC * 1e9 / ops;
+        if (run == 0 || ns < best) best = ns;
+    }
+    
+    return best;
+    
+}
+
+int main() {
+    
+    size_t i, j;
+    
+    srand(1);
+    for (i = 0; i < sizeof(key); i++) key[i] = (uint8_t) rand();
+    for (i = 0; i < ITEMS; i++) {
+        for (j = 0; j < ITEM_LEN; j++) items[i][j] = (uint8_t) rand();
+    }
+    
+    siphash_key_init(&prepared, key);
+    msh_hrw_init(&hrw, key);
+    
+    printf("backend,benchmark,nodes,ns_per_route\n");
+    for (nodes = 16; nodes <= MAX_NODES; nodes *= 4) {
+        while (hrw.count < (size_t) nodes) msh_hrw_add(&hrw, (uint64_t) hrw.count);
+        printf("%d,jump,%d,%.1f\n", MSH_BACKEND, (int) nodes, measure(route_jump));
+        printf("%d,rendezvous,%d,%.1f\n", MSH_BACKEND, (int) nodes, measure(route_hrw));
+        printf("%d,rendezvous_siphash,%d,%.1f\n", MSH_BACKEND, (int) nodes, measure(route_naive));
+        fflush(stdout);
+    }
+    
+    msh_hrw_free(&hrw);
+    
+    return (int) (sink & 0);
+    
+}
@@ -0,0 +1,280 @@
+/*
+ * sketch.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Benchmark of the false positive rate and the error against the throughput of the keyed Bloom
+ * filter and count-min sketch, compared with separate SipHash calls under k keys per item
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "sketch.h"
+
+#define ITEMS (1UL << 19)
+#define ITEM_LEN 16
+#define RUNS 3
+#define MAX_K 16
+
+static uint8_t (*items)[ITEM_LEN], (*others)[ITEM_LEN];
+static const uint8_t **item_ptrs, **other_ptrs;
+static size_t *item_lens;
+static uint8_t *results;
+static uint32_t *counts, *estimates;
+static const uint8_t **stream;
+
+/*
+ * The approach replaced by the module: k hashes under k keys, probing a flat bit array or k rows
+ * of counters.
+ */
+typedef struct {
+    uint32_t *words;
+    uint32_t size;
+    unsigned int k;
+    siphash_key_t keys[MAX_K];
+} naive;
+
+static uint32_t naive_hash(const naive *s, const unsigned int i, const uint8_t *item) {
+    uint8_t hash[8];
+    siphash_with_key(hash, item, ITEM_LEN, &s->keys[i]);
+    return ((uint32_t) hash[0] | ((uint32_t) hash[1] << 8) | ((uint32_t) hash[2] << 16) |
+        ((uint32_t) hash[3] << 24)) % s->size;
+}
+
+static void naive_init(naive *s, const size_t bytes, const unsigned int k) {
+    uint8_t key[16];
+    unsigned int i, j;
+    s->words = calloc(bytes / 4, 4);
+    s->size = (uint32_t) bytes * 8;
+    s->k = k;
+    for (i = 0; i < k; i++) {
+        for (j = 0; j < 16; j++) key[j] = (uint8_t) rand();
+        siphash_key_init(&s->keys[i], key);
+    }
+}
+
+static double elapsed_ns(const clock_t start) {
+    return (double) (clock() - start) / CLOCKS_PER_SEC * 1e9;
+}
+
+static void report(const char *benchmark, const char *variant, const unsigned long param,
+    const size_t memory, const double error, const double add, const double query) {
+    printf("%d,%s,%s,%lu,%lu,%.5f,%.1f,%.1f\n", MSH_BACKEND, benchmark, variant, param,
+        (unsigned long) memory, error, add / ITEMS, query / ITEMS);
+    fflush(stdout);
+}
+
+/*
+ * Each benchmark fills a fresh structure with all the items and queries as many non-members (or
+ * the items of the stream), the best time out of RUNS being reported in ns per item.
+ */
+static void bench_bloom(const unsigned int bits_per_item) {
+    
+    msh_bloom bloom;
+    naive flat;
+    unsigned long i, positives;
+    unsigned int j;
+    uint32_t bit;
+    size_t memory;
+    double add[3], query[3], t;
+    clock_t start;
+    int run, v;
+    
+    for (v = 0; v < 3; v++) add[v] = query[v] = 1e30;
+    
+    for (run = 0; run < RUNS; run++) {
+        
+        /* One by one and batched. */
+        for (v = 0; v < 2; v++) {
+            msh_bloom_init(&bloom, ITEMS, bits_per_item, msh_sketch_urandom);
+            start = clock();
+            if (v) msh_bloom_add_batch(&bloom, item_ptrs, item_lens, ITEMS);
+            else for (i = 0; i < ITEMS; i++) msh_bloom_add(&bloom, items[i], ITEM_LEN);
+            if ((t = elapsed_ns(start)) < add[v]) add[v] = t;
+            start = clock();
+            positives = 0;
+            if (v) {
+                msh_bloom_query_batch(&bloom, other_ptrs, item_lens, ITEMS, results);
+                for (i = 0; i < ITEMS; i++) positives += results[i];
+            } else {
+                for (i = 0; i < ITEMS; i++) positives += (unsigned long) msh_bloom_query(&bloom, others[i], ITEM_LEN);
+            }
+            if ((t = elapsed_ns(start)) < query[v]) query[v] = t;
+            memory = (bloom.block_mask + 1) * MSH_SKETCH_LINE;
+            msh_bloom_free(&bloom);
+            if (run == RUNS - 1) {
+                report("bloom", v ? "batch" : "single", bits_per_item, memory, (double) positives / ITEMS,
+                    add[v], query[v]);
+            }
+        }
+        
+        /* The same memory and k, hashed k times. */
+        naive_init(&flat, memory, bloom.k);
+        start = clock();
+        for (i = 0; i < ITEMS; i++) {
+            for (j = 0; j < flat.k; j++) {
+                bit = naive_hash(&flat, j, items[i]);
+                flat.words[bit >> 5] |= (uint32_t) 1 << (bit & 31);
+            }
+        }
+        if ((t = elapsed_ns(start)) < add[2]) add[2] = t;
+        start = clock();
+        positives = 0;
+        for (i = 0; i < ITEMS; i++) {
+            for (j = 0; j < flat.k; j++) {
+                bit = naive_hash(&flat, j, others[i]);
+                if (!(flat.words[bit >> 5] & ((uint32_t) 1 << (bit & 31)))) break;
+            }
+            positives += j == flat.k;
+        }
+        if ((t = elapsed_ns(start)) < query[2]) query[2] = t;
+        free(flat.words);
+        if (run == RUNS - 1) {
+            report("bloom", "k_keys", bits_per_item, memory, (double) positives / ITEMS, add[2], query[2]);
+        }
+        
+    }
+    
+}
+
+static void bench_cms(const size_t counters, const unsigned int depth) {
+    
+    msh_cms cms;
+    naive rows;
+    unsigned long i, over;
+    unsigned int j;
+    uint32_t idx, min, *row;
+    size_t memory, width = counters / depth;
+    double add[3], query[3], t;
+    clock_t start;
+    int run, v;
+    
+    for (v = 0; v < 3; v++) add[v] = query[v] = 1e30;
+    
+    for (run = 0; run < RUNS; run++) {
+        
+        for (v = 0; v < 2; v++) {
+            msh_cms_init(&cms, counters, depth, msh_sketch_urandom);
+            start = clock();
+            if (v) msh_cms_add_batch(&cms, stream, item_lens, NULL, ITEMS);
+            else for (i = 0; i < ITEMS; i++) msh_cms_add(&cms, stream[i], ITEM_LEN, 1);
+            if ((t = elapsed_ns(start)) < add[v]) add[v] = t;
+            start = clock();
+            if (v) {
+                msh_cms_estimate_batch(&cms, item_ptrs, item_lens, ITEMS, estimates);
+            } else {
+                for (i = 0; i < ITEMS; i++) estimates[i] = msh_cms_estimate(&cms, items[i], ITEM_LEN);
+            }
+            if ((t = elapsed_ns(start)) < query[v]) query[v] = t;
+            memory = (cms.line_mask + 1) * MSH_SKETCH_LINE;
+            msh_cms_free(&cms);
+            for (over = 0, i = 0; i < ITEMS; i++) over += estimates[i] - counts[i];
+            if (run == RUNS - 1) {
+                report("cms", v ? "batch" : "single", (unsigned long) counters, memory,
+                    (double) over / ITEMS, add[v], query[v]);
+            }
+        }
+        
+        /* depth rows of width counters under depth keys, with the conservative update too. */
+        naive_init(&rows, counters * 4, depth);
+        rows.size = (uint32_t) width;
+        start = clock();
+        for (i = 0; i < ITEMS; i++) {
+            min = 0xffffffffUL;
+            for (j = 0; j < depth; j++) {
+                row = rows.words + j * width;
+                idx = naive_hash(&rows, j, stream[i]);
+                if (row[idx] < min) min = row[idx];
+            }
+            for (j = 0; j < depth; j++) {
+                row = rows.words + j * width;
+                idx = naive_hash(&rows, j, stream[i]);
+                if (row[idx] < min + 1) row[idx] = min + 1;
+            }
+        }
+        if ((t = elapsed_ns(start)) < add[2]) add[2] = t;
+        start = clock();
+        for (i = 0; i < ITEMS; i++) {
+            min = 0xffffffffUL;
+            for (j = 0; j < depth; j++) {
+                idx = naive_hash(&rows, j, items[i]);
+                if (rows.words[j * width + idx] < min) min = rows.words[j * width + idx];
+            }
+            estimates[i] = min;
+        }
+        if ((t = elapsed_ns(start)) < query[2]) query[2] = t;
+        free(rows.words);
+        for (over = 0, i = 0; i < ITEMS; i++) over += estimates[i] - counts[i];
+        if (run == RUNS - 1) {
+            report("cms", "k_keys", (unsigned long) counters, counters * 4, (double) over / ITEMS, add[2],
+                query[2]);
+        }
+        
+    }
+    
+}
+
+int main() {
+    
+    static const unsigned int bits[] = {6, 8, 10, 12, 16, 20};
+    static const size_t counters[] = {1UL << 12, 1UL << 16, 1UL << 20};
+    unsigned long i, idx;
+    size_t j;
+    
+    items = malloc(ITEMS * ITEM_LEN);
+    others = malloc(ITEMS * ITEM_LEN);
+    item_ptrs = malloc(ITEMS * sizeof(*item_ptrs));
+    other_ptrs = malloc(ITEMS * sizeof(*other_ptrs));
+    item_lens = malloc(ITEMS * sizeof(*item_lens));
+    results = malloc(ITEMS);
+    counts = calloc(ITEMS, sizeof(*counts));
+    estimates = malloc(ITEMS * sizeof(*estimates));
+    stream = malloc(ITEMS * sizeof(*stream));
+    
+    srand(1);
+    for (i = 0; i < ITEMS; i++) {
+        for (j = 0; j < ITEM_LEN; j++) items[i][j] = (uint8_t) rand();
+        for (j = 0; j < ITEM_LEN; j++) others[i][j] = (uint8_t) rand();
+        item_ptrs[i] = items[i];
+        other_ptrs[i] = others[i];
+        item_lens[i] = ITEM_LEN;
+    }
+    
+    /* Skewed stream of the items for the sketch, low indices being the heavy hitters. */
+    for (i = 0; i < ITEMS; i++) {
+        idx = (unsigned long) rand() % ITEMS;
+        idx = (idx >> 10) * ((unsigned long) rand() % ITEMS) >> 10;
+        counts[idx]++;
+        stream[i] = items[idx];
+    }
+    
+    /* The error is the false positive rate of the filter and the mean overestimate of the sketch. */
+    printf("backend,benchmark,variant,param,memory,error,add_ns_per_item,query_ns_per_item\n");
+    for (j = 0; j < sizeof(bits) / sizeof(bits[0]); j++) bench_bloom(bits[j]);
+    for (j = 0; j < sizeof(counters) / sizeof(counters[0]); j++) bench_cms(counters[j], 4);
+    
+    return 0;
+    
+}
@@ -0,0 +1,107 @@
+/*
+ * tree.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Throughput of the tree hash mode of extras/tree by the number of threads, compared to a single
+ * siphash() over the same input, printed as CSV
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "siphash_tree.h"
+
+#define LEN ((size_t) 64 << 20)
+#define RUNS 3
+#define MAX_THREADS 64
+
+static uint8_t *data, key[16], hash[8];
+static msh_pool pool;
+
+/* Wall clock time in seconds, as CPU time would add up across the threads. */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void hash_flat(void) {
+    siphash(hash, data, LEN, key);
+}
+
+static void hash_tree(void) {
+    siphash_tree(hash, data, LEN, SIPHASH_TREE_LEAF, key, &pool);
+}
+
+/*
+ * MB/s, the best out of RUNS measurements.
+ */
+static double measure(void (*fn)(void)) {
+    
+    double start, rate, best = 0;
+    int run;
+    
+    for (run = 0; run < RUNS; run++) {
+        start = now();
+        fn();
+        rate = LEN / (now() - start) / 1e6;
+        if (rate > best) best = rate;
+    }
+    
+    return best;
+    
+}
+
+int main() {
+    
+    size_t i;
+    int threads, cpus = msh_pool_cpus();
+    
+    data = malloc(LEN);
+    if (!data) return 1;
+    for (i = 0; i < LEN; i++) data[i] = (uint8_t) i;
+    
+    printf("backend,benchmark,threads,bytes,mb_per_sec\n");
+    printf("%d,siphash,1,%lu,%.2f\n", MSH_BACKEND, (unsigned long) LEN, measure(hash_flat));
+    
+    threads = 1;
+    while (threads <= MAX_THREADS && threads <= cpus) {
+        if (msh_pool_init(&pool, threads)) return 1;
+        printf("%d,siphash_tree,%d,%lu,%.2f\n", MSH_BACKEND, threads, (unsigned long) LEN,
+            measure(hash_tree));
+        fflush(stdout);
+        msh_pool_free(&pool);
+        /* Powers of two, the last step being all the CPUs. */
+        threads = threads < cpus && threads * 2 > cpus ? cpus : threads * 2;
+    }
+    
+    free(data);
+    
+    return 0;
+    
+}
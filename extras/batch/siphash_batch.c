@@ -0,0 +1,568 @@
+/*
+ * siphash_batch.c
+ * Multi-lane SIMD batch hashing based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Messages are assigned to the lanes of SIMD registers and absorbed in lockstep, block by block.
+ * Lanes holding messages shorter than the longest one in the group are masked out once their
+ * blocks are exhausted, so the messages may have arbitrary lengths. The SSE2, AVX2 and AVX-512
+ * kernels are built only with GCC compatible compilers for x86, elsewhere the batch falls back to
+ * sequential siphash_with_key() calls.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include "siphash_batch.h"
+
+static void _msh_batch_scalar(uint8_t *hashes, const uint8_t *const *datas, const size_t *lens,
+    const size_t n, const uint8_t *key) {
+    
+    siphash_key_t prepared;
+    size_t i;
+    
+    siphash_key_init(&prepared, key);
+    
+    for (i = 0; i < n; i++) siphash_with_key(hashes + 8 * i, datas[i], lens[i], &prepared);
+    
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#define _MSH_BATCH_SIMD
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define _MSH_MAX_LANES 8
+
+/*
+ * Returns the j-th message word of the message p of length len, the final one carrying the length.
+ */
+static uint64_t _msh_batch_word(const uint8_t *p, const size_t len, const size_t j) {
+    
+    uint64_t word;
+    size_t offset = j << 3, left = len - offset;
+    int i;
+    
+    /* Whole words are assembled by a constant expression, which compiles to a single load. */
+    if (left >= 8) {
+        p += offset;
+        return ((uint64_t) p[0])       | ((uint64_t) p[1] << 8)  |
+               ((uint64_t) p[2] << 16) | ((uint64_t) p[3] << 24) |
+               ((uint64_t) p[4] << 32) | ((uint64_t) p[5] << 40) |
+               ((uint64_t) p[6] << 48) | ((uint64_t) p[7] << 56);
+    }
+    
+    word = (uint64_t) (len & 0xff) << 56;
+    for (i = 0; i < (int) left; i++) word |= (uint64_t) p[offset + i] << (i << 3);
+    
+    return word;
+    
+}
+
+/*
+ * Every kernel defines the following primitives over the vector type _msh_vec, where each lane holds
+ * a single 64-bit word:
+ *
+ *  _V_SET1(v,x)            broadcast x to all the lanes of v
+ *  _V_SCALARS(v,p)         load v from the array of uint64_t element by element, so that the words
+ *                          just stored to the array are forwarded to the loads
+ *  _V_STORE(p,v)           store v to the array of uint64_t
+ *  _V_ADD(v,s)             v += s
+ *  _V_XOR(v,s)             v ^= s
+ *  _V_ROTL(v,b)            rotate v left by b bits
+ *  _V_ROTL32(v)            rotate v left by 32 bits
+ *  _V_BLEND(v,old,mask)    keep v in lanes where mask is all ones, restore old elsewhere
+ *  _V_WORDS(v,ps,o)        load the little-endian word at ps[l] + o to each lane l
+ */
+
+#define _V_SIPHASH_ROUND() {                                \
+    _V_ADD(v0, v1);                                         \
+    _V_ADD(v2, v3);                                         \
+    _V_ROTL(v1, 13);                                        \
+    _V_ROTL(v3, 16);                                        \
+                                                            \
+    _V_XOR(v1, v0);                                         \
+    _V_XOR(v3, v2);                                         \
+    _V_ROTL32(v0);                                          \
+                                                            \
+    _V_ADD(v2, v1);                                         \
+    _V_ADD(v0, v3);                                         \
+    _V_ROTL(v1, 17);                                        \
+    _V_ROTL(v3, 21);                                        \
+                                                            \
+    _V_XOR(v1, v2);                                         \
+    _V_XOR(v3, v0);                                         \
+    _V_ROTL32(v2);                                          \
+}
+
+#define _V_COMPRESS() {                                     \
+    _V_XOR(v3, m);                                          \
+    _V_SIPHASH_ROUND();                                     \
+    _V_SIPHASH_ROUND();                                     \
+    _V_XOR(v0, m);                                          \
+}
+
+/*
+ * Defines the kernel hashing up to lanes messages in lockstep. The init rows hold the initial state
+ * words v0..v3 of every lane, so each lane may use its own key.
+ */
+#define _MSH_BATCH_KERNEL(name, isa, lanes)                                                 \
+__attribute__((target(isa)))                                                                \
+static void name(uint8_t *hashes, const uint8_t *const *datas, const size_t *lens,          \
+    const size_t cnt, const uint64_t (*init)[_MSH_MAX_LANES]) {                             \
+                                                                                            \
+    uint64_t words[lanes], active[lanes];                                                   \
+    size_t blocks[lanes], min_blocks = (size_t) -1, max_blocks = 0, whole, j;               \
+    _msh_vec v0, v1, v2, v3, m, mask, o0, o1, o2, o3;                                       \
+    int l, _i;                                                                              \
+                                                                                            \
+    for (l = 0; l < (lanes); l++) {                                                         \
+        blocks[l] = 0;                                                                      \
+        if (l < (int) cnt) {                                                                \
+            blocks[l] = (lens[l] >> 3) + 1;                                                 \
+            if (blocks[l] < min_blocks) min_blocks = blocks[l];                             \
+            if (blocks[l] > max_blocks) max_blocks = blocks[l];                             \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    _V_SCALARS(v0, init[0]);                                                                \
+    _V_SCALARS(v1, init[1]);                                                                \
+    _V_SCALARS(v2, init[2]);                                                                \
+    _V_SCALARS(v3, init[3]);                                                                \
+                                                                                            \
+    /* Words complete in every lane are loaded straight from the messages. */               \
+    whole = cnt == (lanes) ? min_blocks - 1 : 0;                                            \
+    for (j = 0; j < whole; j++) {                                                           \
+        _V_WORDS(m, datas, j << 3);                                                         \
+        _V_COMPRESS();                                                                      \
+    }                                                                                       \
+                                                                                            \
+    for (j = whole; j < max_blocks; j++) {                                                  \
+        if (j < min_blocks) {                                                               \
+            /* All the lanes are busy, no masking required. */                              \
+            for (l = 0; l < (lanes); l++) {                                                 \
+                words[l] = l < (int) cnt ? _msh_batch_word(datas[l], lens[l], j) : 0;       \
+            }                                                                               \
+            _V_SCALARS(m, words);                                                           \
+            _V_COMPRESS();                                                                  \
+        } else {                                                                            \
+            for (l = 0; l < (lanes); l++) {                                                 \
+                if (j < blocks[l]) {                                                        \
+                    words[l] = _msh_batch_word(datas[l], lens[l], j);                       \
+                    active[l] = ~(uint64_t) 0;                                              \
+                } else {                                                                    \
+                    words[l] = 0;                                                           \
+                    active[l] = 0;                                                          \
+                }                                                                           \
+            }                                                                               \
+            _V_SCALARS(m, words);                                                           \
+            _V_SCALARS(mask, active);                                                       \
+            o0 = v0; o1 = v1; o2 = v2; o3 = v3;                                             \
+            _V_COMPRESS();                                                                  \
+            _V_BLEND(v0, o0, mask);                                                         \
+            _V_BLEND(v1, o1, mask);                                                         \
+            _V_BLEND(v2, o2, mask);                                                         \
+            _V_BLEND(v3, o3, mask);                                                         \
+        }                                                                                   \
+    }                                                                                       \
+                                                                                            \
+    _V_SET1(m, 0xff);                                                                       \
+    _V_XOR(v2, m);                                                                          \
+    _V_SIPHASH_ROUND();                                                                     \
+    _V_SIPHASH_ROUND();                                                                     \
+    _V_SIPHASH_ROUND();                                                                     \
+    _V_SIPHASH_ROUND();                                                                     \
+                                                                                            \
+    _V_XOR(v0, v1);                                                                         \
+    _V_XOR(v0, v2);                                                                         \
+    _V_XOR(v0, v3);                                                                         \
+    _V_STORE(words, v0);                                                                    \
+                                                                                            \
+    for (l = 0; l < (int) cnt; l++) {                                                       \
+        for (_i = 0; _i < 8; _i++) hashes[8 * l + _i] = (uint8_t) (words[l] >> (_i << 3));  \
+    }                                                                                       \
+                                                                                            \
+}
+
+/*
+ * SSE2, four lanes held in pairs of 128-bit registers.
+ */
+
+typedef struct {
+    __m128i lo, hi;
+} _msh_vec_sse2;
+
+#define _msh_vec _msh_vec_sse2
+
+#define _V_SET1(v,x) {                                      \
+    (v).lo = (v).hi = _mm_set1_epi64x((long long) (x));     \
+}
+
+#define _V_SCALARS(v,p) {                                   \
+    (v).lo = _mm_set_epi64x((long long) (p)[1],             \
+        (long long) (p)[0]);                                \
+    (v).hi = _mm_set_epi64x((long long) (p)[3],             \
+        (long long) (p)[2]);                                \
+}
+
+#define _V_STORE(p,v) {                                     \
+    _mm_storeu_si128((__m128i *) (p), (v).lo);              \
+    _mm_storeu_si128((__m128i *) (p) + 1, (v).hi);          \
+}
+
+#define _V_ADD(v,s) {                                       \
+    (v).lo = _mm_add_epi64((v).lo, (s).lo);                 \
+    (v).hi = _mm_add_epi64((v).hi, (s).hi);                 \
+}
+
+#define _V_XOR(v,s) {                                       \
+    (v).lo = _mm_xor_si128((v).lo, (s).lo);                 \
+    (v).hi = _mm_xor_si128((v).hi, (s).hi);                 \
+}
+
+#define _V_ROTL(v,b) {                                      \
+    (v).lo = _mm_or_si128(_mm_slli_epi64((v).lo, b),        \
+        _mm_srli_epi64((v).lo, 64 - (b)));                  \
+    (v).hi = _mm_or_si128(_mm_slli_epi64((v).hi, b),        \
+        _mm_srli_epi64((v).hi, 64 - (b)));                  \
+}
+
+#define _V_ROTL32(v) {                                      \
+    (v).lo = _mm_shuffle_epi32((v).lo, 0xb1);               \
+    (v).hi = _mm_shuffle_epi32((v).hi, 0xb1);               \
+}
+
+#define _V_BLEND(v,old,mask) {                              \
+    (v).lo = _mm_or_si128(_mm_and_si128((mask).lo, (v).lo), \
+        _mm_andnot_si128((mask).lo, (old).lo));             \
+    (v).hi = _mm_or_si128(_mm_and_si128((mask).hi, (v).hi), \
+        _mm_andnot_si128((mask).hi, (old).hi));             \
+}
+
+#define _V_PAIR(ps,i,o)                                     \
+    _mm_unpacklo_epi64(                                     \
+        _mm_loadl_epi64((const __m128i *) ((ps)[i] + (o))), \
+        _mm_loadl_epi64((const __m128i *) ((ps)[(i) + 1] + (o))))
+
+#define _V_WORDS(v,ps,o) {                                  \
+    (v).lo = _V_PAIR(ps, 0, o);                             \
+    (v).hi = _V_PAIR(ps, 2, o);                             \
+}
+
+_MSH_BATCH_KERNEL(_msh_batch_sse2, "sse2", 4)
+
+#undef _msh_vec
+#undef _V_SET1
+#undef _V_SCALARS
+#undef _V_STORE
+#undef _V_ADD
+#undef _V_XOR
+#undef _V_ROTL
+#undef _V_ROTL32
+#undef _V_BLEND
+#undef _V_WORDS
+
+/*
+ * AVX2, four lanes in a single 256-bit register.
+ */
+
+#define _msh_vec __m256i
+
+#define _V_SET1(v,x) {                                      \
+    (v) = _mm256_set1_epi64x((long long) (x));              \
+}
+
+#define _V_SCALARS(v,p) {                                   \
+    (v) = _mm256_set_epi64x((long long) (p)[3],             \
+        (long long) (p)[2], (long long) (p)[1],             \
+        (long long) (p)[0]);                                \
+}
+
+#define _V_STORE(p,v) {                                     \
+    _mm256_storeu_si256((__m256i *) (p), v);                \
+}
+
+#define _V_ADD(v,s) {                                       \
+    (v) = _mm256_add_epi64(v, s);                           \
+}
+
+#define _V_XOR(v,s) {                                       \
+    (v) = _mm256_xor_si256(v, s);                           \
+}
+
+#define _V_ROTL(v,b) {                                      \
+    (v) = _mm256_or_si256(_mm256_slli_epi64(v, b),          \
+        _mm256_srli_epi64(v, 64 - (b)));                    \
+}
+
+#define _V_ROTL32(v) {                                      \
+    (v) = _mm256_shuffle_epi32(v, 0xb1);                    \
+}
+
+#define _V_BLEND(v,old,mask) {                              \
+    (v) = _mm256_blendv_epi8(old, v, mask);                 \
+}
+
+#define _V_WORDS(v,ps,o) {                                  \
+    (v) = _mm256_inserti128_si256(                          \
+        _mm256_castsi128_si256(_V_PAIR(ps, 0, o)),          \
+        _V_PAIR(ps, 2, o), 1);                              \
+}
+
+_MSH_BATCH_KERNEL(_msh_batch_avx2, "avx2", 4)
+
+#undef _msh_vec
+#undef _V_SET1
+#undef _V_SCALARS
+#undef _V_STORE
+#undef _V_ADD
+#undef _V_XOR
+#undef _V_ROTL
+#undef _V_ROTL32
+#undef _V_BLEND
+#undef _V_WORDS
+
+/*
+ * AVX-512, eight lanes in a single 512-bit register.
+ */
+
+#define _msh_vec __m512i
+
+#define _V_SET1(v,x) {                                      \
+    (v) = _mm512_set1_epi64((long long) (x));               \
+}
+
+#define _V_SCALARS(v,p) {                                   \
+    (v) = _mm512_set_epi64((long long) (p)[7],              \
+        (long long) (p)[6], (long long) (p)[5],             \
+        (long long) (p)[4], (long long) (p)[3],             \
+        (long long) (p)[2], (long long) (p)[1],             \
+        (long long) (p)[0]);                                \
+}
+
+#define _V_STORE(p,v) {                                     \
+    _mm512_storeu_si512((void *) (p), v);                   \
+}
+
+#define _V_ADD(v,s) {                                       \
+    (v) = _mm512_add_epi64(v, s);                           \
+}
+
+#define _V_XOR(v,s) {                                       \
+    (v) = _mm512_xor_si512(v, s);                           \
+}
+
+#define _V_ROTL(v,b) {                                      \
+    (v) = _mm512_rol_epi64(v, b);                           \
+}
+
+#define _V_ROTL32(v) {                                      \
+    (v) = _mm512_rol_epi64(v, 32);                          \
+}
+
+#define _V_BLEND(v,old,mask) {                              \
+    (v) = _mm512_mask_mov_epi64(old,                        \
+        _mm512_test_epi64_mask(mask, mask), v);             \
+}
+
+#define _V_WORDS(v,ps,o) {                                  \
+    (v) = _mm512_inserti64x4(_mm512_castsi256_si512(        \
+        _mm256_inserti128_si256(                            \
+            _mm256_castsi128_si256(_V_PAIR(ps, 0, o)),      \
+            _V_PAIR(ps, 2, o), 1)),                         \
+        _mm256_inserti128_si256(                            \
+            _mm256_castsi128_si256(_V_PAIR(ps, 4, o)),      \
+            _V_PAIR(ps, 6, o), 1), 1);                      \
+}
+
+_MSH_BATCH_KERNEL(_msh_batch_avx512, "avx512f", 8)
+
+typedef void (*_msh_batch_kernel)(uint8_t *, const uint8_t *const *, const size_t *, const size_t,
+    const uint64_t (*)[_MSH_MAX_LANES]);
+
+static const _msh_batch_kernel _msh_kernels[] = {
+    NULL, _msh_batch_sse2, _msh_batch_avx2, _msh_batch_avx512
+};
+
+static const int _msh_kernel_lanes[] = {1, 4, 4, 8};
+
+/*
+ * Returns the most capable kernel supported by both the CPU and the operating system.
+ */
+static int _msh_batch_detect(void) {
+    
+    unsigned int eax, ebx, ecx, edx, xcr0_lo, xcr0_hi;
+    int isa = SIPHASH_BATCH_SCALAR;
+    
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return isa;
+    if (edx & (1u << 26)) isa = SIPHASH_BATCH_SSE2;
+    
+    /* Wider registers are usable only if the OS saves their state, as reported by XCR0. */
+    if (!(ecx & (1u << 27)) || !(ecx & (1u << 28))) return isa;
+    __asm__ __volatile__ ("xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+    if ((xcr0_lo & 0x06) != 0x06) return isa;
+    
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return isa;
+    if (ebx & (1u << 5)) isa = SIPHASH_BATCH_AVX2;
+    if ((ebx & (1u << 16)) && (xcr0_lo & 0xe6) == 0xe6) isa = SIPHASH_BATCH_AVX512;
+    
+    return isa;
+    
+}
+
+#endif
+
+/*
+ * The selected kernel, detected lazily by the first batch. Batches may run concurrently, so it is
+ * accessed atomically; racing detections store the same value.
+ */
+static int _msh_batch_isa = SIPHASH_BATCH_AUTO;
+
+#if defined(__GNUC__)
+#define _MSH_ISA_LOAD() __atomic_load_n(&_msh_batch_isa, __ATOMIC_ACQUIRE)
+#define _MSH_ISA_STORE(isa) __atomic_store_n(&_msh_batch_isa, isa, __ATOMIC_RELEASE)
+#else
+#define _MSH_ISA_LOAD() (_msh_batch_isa)
+#define _MSH_ISA_STORE(isa) (_msh_batch_isa = (isa))
+#endif
+
+int siphash_batch_select(const int isa) {
+    
+#ifdef _MSH_BATCH_SIMD
+    int supported = _msh_batch_detect();
+#else
+    int supported = SIPHASH_BATCH_SCALAR;
+#endif
+    
+    if (isa == SIPHASH_BATCH_AUTO) {
+        _MSH_ISA_STORE(supported);
+        return supported;
+    } else if (isa >= SIPHASH_BATCH_SCALAR && isa <= supported) {
+        _MSH_ISA_STORE(isa);
+        return isa;
+    }
+    
+    return -1;
+    
+}
+
+/*
+ * Returns the selected kernel, detecting it on the first call.
+ */
+static int _msh_batch_current(void) {
+    int isa = _MSH_ISA_LOAD();
+    return isa == SIPHASH_BATCH_AUTO ? siphash_batch_select(SIPHASH_BATCH_AUTO) : isa;
+}
+
+#ifdef _MSH_BATCH_SIMD
+/*
+ * Sets up the initial state of the lane for the 16 byte key.
+ */
+static void _msh_batch_key(uint64_t (*init)[_MSH_MAX_LANES], const int lane, const uint8_t *key) {
+    
+    uint64_t k0 = _msh_batch_word(key, 16, 0), k1 = _msh_batch_word(key, 16, 1);
+    
+    init[0][lane] = k0 ^ UINT64_C(0x736f6d6570736575);
+    init[1][lane] = k1 ^ UINT64_C(0x646f72616e646f6d);
+    init[2][lane] = k0 ^ UINT64_C(0x6c7967656e657261);
+    init[3][lane] = k1 ^ UINT64_C(0x7465646279746573);
+    
+}
+
+#endif
+
+void siphash_batch(uint8_t *hashes, const uint8_t *const *datas, const size_t *lens, const size_t n,
+    const uint8_t *key) {
+    
+    int isa;
+#ifdef _MSH_BATCH_SIMD
+    _msh_batch_kernel kernel;
+    uint64_t init[4][_MSH_MAX_LANES];
+    size_t i, lanes, cnt;
+    int l;
+#endif
+    
+    isa = _msh_batch_current();
+    
+#ifdef _MSH_BATCH_SIMD
+    if (isa != SIPHASH_BATCH_SCALAR) {
+        
+        kernel = _msh_kernels[isa];
+        lanes = (size_t) _msh_kernel_lanes[isa];
+        
+        for (l = 0; l < _MSH_MAX_LANES; l++) _msh_batch_key(init, l, key);
+        
+        for (i = 0; i < n; i += lanes) {
+            cnt = n - i < lanes ? n - i : lanes;
+            kernel(hashes + 8 * i, datas + i, lens + i, cnt, (const uint64_t (*)[_MSH_MAX_LANES]) init);
+        }
+        
+        return;
+        
+    }
+#endif
+    
+    (void) isa;
+    _msh_batch_scalar(hashes, datas, lens, n, key);
+    
+}
+
+void siphash_batch_keys(uint8_t *hashes, const uint8_t *const *datas, const size_t *lens,
+    const size_t n, const uint8_t *const *keys) {
+    
+    size_t i;
+    int isa;
+#ifdef _MSH_BATCH_SIMD
+    _msh_batch_kernel kernel;
+    uint64_t init[4][_MSH_MAX_LANES];
+    size_t lanes, cnt;
+    int l;
+#endif
+    
+    isa = _msh_batch_current();
+    
+#ifdef _MSH_BATCH_SIMD
+    if (isa != SIPHASH_BATCH_SCALAR) {
+        
+        kernel = _msh_kernels[isa];
+        lanes = (size_t) _msh_kernel_lanes[isa];
+        
+        /* Lanes past the end of the batch are hashed, but their results are dropped. */
+        memset(init, 0, sizeof(init));
+        
+        for (i = 0; i < n; i += lanes) {
+            cnt = n - i < lanes ? n - i : lanes;
+            for (l = 0; l < (int) cnt; l++) _msh_batch_key(init, l, keys[i + l]);
+            kernel(hashes + 8 * i, datas + i, lens + i, cnt, (const uint64_t (*)[_MSH_MAX_LANES]) init);
+        }
+        
+        return;
+        
+    }
+#endif
+    
+    (void) isa;
+    for (i = 0; i < n; i++) siphash(hashes + 8 * i, datas[i], lens[i], keys[i]);
+    
+}
@@ -0,0 +1,70 @@
+/*
+ * siphash_batch.h
+ * Multi-lane SIMD batch hashing based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ *
+ * Computes SipHash-2-4 of many independent messages under a single key, running several messages in
+ * lockstep across the lanes of SIMD registers. The instruction set is chosen at runtime.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+#ifndef _BATCH_SIPHASH_H
+#define _BATCH_SIPHASH_H
+
+#include "siphash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIPHASH_BATCH_AUTO -1
+#define SIPHASH_BATCH_SCALAR 0
+#define SIPHASH_BATCH_SSE2 1
+#define SIPHASH_BATCH_AVX2 2
+#define SIPHASH_BATCH_AVX512 3
+
+/*
+ * Hash n messages datas[i] of lengths lens[i] under the 16 byte key. The hash of the i-th message is
+ * stored under hashes + 8 * i, the same as siphash() would produce.
+ */
+void siphash_batch(uint8_t *hashes, const uint8_t *const *datas, const size_t *lens, const size_t n,
+    const uint8_t *key);
+
+/*
+ * The same as siphash_batch(), each message i being hashed under its own 16 byte key keys[i].
+ */
+void siphash_batch_keys(uint8_t *hashes, const uint8_t *const *datas, const size_t *lens,
+    const size_t n, const uint8_t *const *keys);
+
+/*
+ * Force the kernel used by siphash_batch(), or restore the runtime detection with SIPHASH_BATCH_AUTO.
+ * Returns the selected kernel, or -1 if the requested one is not supported by the CPU. Safe to call
+ * concurrently with the batches, which then use either the kernel before or after the selection.
+ */
+int siphash_batch_select(const int isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
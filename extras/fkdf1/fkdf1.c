@@ -32,10 +32,6 @@
  * 
  */
 
-#ifndef KDF_INFO_LEN
-#define KDF_INFO_LEN 32
-#endif
-
 #include "fkdf1.h"
 
 int kdf1(uint8_t *derived_key, const size_t derived_key_length,
@@ -36,8 +36,35 @@
 #include "stdio.h"
 #include <stdlib.h>
 
+#ifndef KDF_INFO_LEN
+#define KDF_INFO_LEN 32
+#endif
+
+/* Scratch memory required by kdf1_batch() for n derivations. */
+#define KDF_BATCH_SCRATCH(n) ((n) * (KDF_INFO_LEN + 4))
+
 int kdf1(uint8_t *derived_key, const size_t derived_key_length,
     const uint8_t *info, const size_t info_len,
     const uint8_t *hash_key);
 
+/*
+ * Derive n keys at once, the i-th one from infos[i] under hash_keys[i], stored under
+ * derived_keys + i * derived_key_length. The derivations are spread across SIMD lanes. The
+ * scratch shall hold KDF_BATCH_SCRATCH(n) bytes. Defined in fkdf1_batch.c.
+ */
+int kdf1_batch(uint8_t *derived_keys, const size_t derived_key_length,
+    const uint8_t *const *infos, const size_t *info_lens,
+    const uint8_t *const *hash_keys, const size_t n, uint8_t *scratch);
+
+#ifdef KDF_THREADS
+#include "pool.h"
+
+/*
+ * The same as kdf1_batch(), with large batches split across the threads of the pool.
+ */
+int kdf1_batch_parallel(uint8_t *derived_keys, const size_t derived_key_length,
+    const uint8_t *const *infos, const size_t *info_lens,
+    const uint8_t *const *hash_keys, const size_t n, uint8_t *scratch, msh_pool *pool);
+#endif
+
 #endif
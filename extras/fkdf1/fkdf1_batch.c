@@ -0,0 +1,138 @@
+/*
+ * fkdf1_batch.c
+ * Simple semi-KDF1 based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Batched derivations over the siphash_batch_keys() kernels, kept apart from kdf1() so that the
+ * single key derivation builds without extras/batch.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include "fkdf1.h"
+#include "siphash_batch.h"
+
+/* Messages hashed by a single siphash_batch_keys() call. */
+#define KDF_BATCH_CHUNK 64
+
+/* Messages per task of the thread pool. */
+#define KDF_BATCH_TASK 256
+
+int kdf1_batch(uint8_t *derived_keys, const size_t derived_key_length,
+    const uint8_t *const *infos, const size_t *info_lens,
+    const uint8_t *const *hash_keys, const size_t n, uint8_t *scratch) {
+    
+    uint8_t hashes[8 * KDF_BATCH_CHUNK], *buffer, counter;
+    const uint8_t *datas[KDF_BATCH_CHUNK];
+    size_t lens[KDF_BATCH_CHUNK], offset, first, cnt, i;
+    
+    if (derived_key_length > 1023) return -1;
+    for (i = 0; i < n; i++) {
+        if (info_lens[i] > KDF_INFO_LEN) return -1;
+    }
+    
+    for (first = 0; first < n; first += cnt) {
+        
+        cnt = n - first < KDF_BATCH_CHUNK ? n - first : KDF_BATCH_CHUNK;
+        
+        /* Each derivation owns its slice of the scratch, laid out just like the kdf1() buffer. */
+        for (i = 0; i < cnt; i++) {
+            buffer = scratch + (first + i) * (KDF_INFO_LEN + 4);
+            memset(buffer, 0x00, 4);
+            memcpy(buffer + 4, infos[first + i], info_lens[first + i]);
+            datas[i] = buffer;
+            lens[i] = 4 + info_lens[first + i];
+        }
+        
+        /* The same counter block of all the derivations at once. */
+        for (offset = 0, counter = 0; offset < derived_key_length; offset += 8, counter++) {
+            
+            for (i = 0; i < cnt; i++) scratch[(first + i) * (KDF_INFO_LEN + 4) + 3] = counter;
+            
+            siphash_batch_keys(hashes, datas, lens, cnt, hash_keys + first);
+            
+            for (i = 0; i < cnt; i++) {
+                memcpy(derived_keys + (first + i) * derived_key_length + offset, hashes + 8 * i,
+                    offset + 8 > derived_key_length ? derived_key_length - offset : 8);
+            }
+            
+        }
+        
+    }
+    
+    return 0;
+    
+}
+
+#ifdef KDF_THREADS
+
+typedef struct {
+    uint8_t *derived_keys;
+    size_t derived_key_length;
+    const uint8_t *const *infos;
+    const size_t *info_lens;
+    const uint8_t *const *hash_keys;
+    size_t n;
+    uint8_t *scratch;
+} _kdf_batch_job;
+
+static void _kdf_batch_task(void *arg, size_t task) {
+    
+    _kdf_batch_job *job = (_kdf_batch_job *) arg;
+    size_t first = task * KDF_BATCH_TASK;
+    size_t cnt = job->n - first < KDF_BATCH_TASK ? job->n - first : KDF_BATCH_TASK;
+    
+    kdf1_batch(job->derived_keys + first * job->derived_key_length, job->derived_key_length,
+        job->infos + first, job->info_lens + first, job->hash_keys + first, cnt,
+        job->scratch + first * (KDF_INFO_LEN + 4));
+    
+}
+
+int kdf1_batch_parallel(uint8_t *derived_keys, const size_t derived_key_length,
+    const uint8_t *const *infos, const size_t *info_lens,
+    const uint8_t *const *hash_keys, const size_t n, uint8_t *scratch, msh_pool *pool) {
+    
+    _kdf_batch_job job;
+    size_t i;
+    
+    /* Validate up front, the tasks have no way to report an error. */
+    if (derived_key_length > 1023) return -1;
+    for (i = 0; i < n; i++) {
+        if (info_lens[i] > KDF_INFO_LEN) return -1;
+    }
+    
+    job.derived_keys = derived_keys;
+    job.derived_key_length = derived_key_length;
+    job.infos = infos;
+    job.info_lens = info_lens;
+    job.hash_keys = hash_keys;
+    job.n = n;
+    job.scratch = scratch;
+    
+    msh_pool_run(pool, _kdf_batch_task, &job, (n + KDF_BATCH_TASK - 1) / KDF_BATCH_TASK);
+    
+    return 0;
+    
+}
+
+#endif
@@ -0,0 +1,342 @@
+/*
+ * hashmap.c
+ * Flooding-resistant open-addressing hash map based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * The layout follows SwissTable: a flat array of slots accompanied by an array of control bytes,
+ * one per slot. The control byte holds 7 bits of the hash of the key in the slot, or marks it empty
+ * or deleted, so the lookup matches a whole group of 8 control bytes, which share a cache line, at
+ * once before touching any slot. Groups are probed in triangular sequence, which visits each of them
+ * once if the number of groups is a power of two.
+ * 
+ * This implementation utilizes dynamically allocated buffers.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include "hashmap.h"
+
+#define _MSH_EMPTY 0x80
+#define _MSH_DELETED 0xfe
+
+/* Maximal load factor of 7/8, tombstones included. */
+#define _MSH_MAX_LOAD(capacity) ((capacity) - (capacity) / 8)
+
+/* Maximal number of slots, so that their size fits in size_t. */
+#define _MSH_MAX_SLOTS ((size_t) -1 / sizeof(msh_map_slot))
+
+/*
+ * Groups are matched as 64-bit words, control byte i in byte i of the word. Matching bytes are
+ * reported in their top bit.
+ */
+#define _MSH_LSB UINT64_C(0x0101010101010101)
+#define _MSH_MSB UINT64_C(0x8080808080808080)
+
+int msh_map_urandom(uint8_t *buf, const size_t len) {
+    
+    FILE *f = fopen("/dev/urandom", "rb");
+    size_t got;
+    
+    if (!f) return -1;
+    got = fread(buf, 1, len, f);
+    fclose(f);
+    
+    return got == len ? 0 : -1;
+    
+}
+
+/*
+ * The first four bytes of the hash select the group, the fifth one gives the control byte.
+ */
+static uint32_t _msh_map_hash(const msh_map *map, const uint8_t *key, const size_t key_len,
+    uint8_t *h2) {
+    
+    uint8_t hash[8];
+    
+    map->hash(hash, key, key_len, &map->key);
+    *h2 = hash[4] & 0x7f;
+    
+    return (uint32_t) hash[0] | ((uint32_t) hash[1] << 8) | ((uint32_t) hash[2] << 16) |
+        ((uint32_t) hash[3] << 24);
+    
+}
+
+/*
+ * Loads the control bytes of the group. The expression compiles to a single load.
+ */
+static uint64_t _msh_map_group(const uint8_t *ctrl) {
+    return ((uint64_t) ctrl[0])       | ((uint64_t) ctrl[1] << 8)  |
+           ((uint64_t) ctrl[2] << 16) | ((uint64_t) ctrl[3] << 24) |
+           ((uint64_t) ctrl[4] << 32) | ((uint64_t) ctrl[5] << 40) |
+           ((uint64_t) ctrl[6] << 48) | ((uint64_t) ctrl[7] << 56);
+}
+
+/*
+ * Control bytes of the group equal to c, found as the zero bytes of the group xored with c. The
+ * borrow of a zero byte may flag the byte above it as well, if it differs from c in the lowest bit
+ * only. That never happens for c empty, the other bytes being full or deleted. Matches of h2 are
+ * confirmed against the slot, so a spurious one costs only the comparison.
+ */
+static uint64_t _msh_map_match(const uint64_t group, const uint8_t c) {
+    uint64_t x = group ^ (_MSH_LSB * c);
+    return (x - _MSH_LSB) & ~x & _MSH_MSB;
+}
+
+/*
+ * Index of the lowest match, the mask being non-zero.
+ */
+static size_t _msh_map_first(uint64_t match) {
+#if defined(__GNUC__)
+    return (size_t) __builtin_ctzll(match) >> 3;
+#else
+    size_t i = 0;
+    while (!(match & 0x80)) {
+        match >>= 8;
+        i++;
+    }
+    return i;
+#endif
+}
+
+static int _msh_map_alloc(msh_map *map, const size_t capacity) {
+    
+    size_t slots = MSH_MAP_GROUP;
+    
+    /* Power of two number of slots keeping the load under the limit. */
+    while (_MSH_MAX_LOAD(slots) < capacity) {
+        if (slots > _MSH_MAX_SLOTS / 2) return -2;
+        slots *= 2;
+    }
+    
+    map->ctrl = malloc(slots);
+    map->slots = malloc(slots * sizeof(msh_map_slot));
+    if (!map->ctrl || !map->slots) {
+        free(map->ctrl);
+        free(map->slots);
+        return -2;
+    }
+    
+    memset(map->ctrl, _MSH_EMPTY, slots);
+    map->capacity = slots;
+    map->size = 0;
+    map->tombstones = 0;
+    
+    return 0;
+    
+}
+
+/*
+ * Place the entry known not to be in the map in the first free slot of its probe sequence. Returns
+ * the length of the probe sequence in groups.
+ */
+static size_t _msh_map_place(msh_map *map, const msh_map_slot *entry, const uint8_t h2) {
+    
+    size_t mask = map->capacity / MSH_MAP_GROUP - 1;
+    size_t group = entry->hash & mask, probe = 0, idx;
+    uint64_t free_slots;
+    
+    for (;;) {
+        /* Empty and deleted slots are the ones with the top bit set. */
+        free_slots = _msh_map_group(map->ctrl + group * MSH_MAP_GROUP) & _MSH_MSB;
+        if (free_slots) {
+            idx = group * MSH_MAP_GROUP + _msh_map_first(free_slots);
+            if (map->ctrl[idx] == _MSH_DELETED) map->tombstones--;
+            map->ctrl[idx] = h2;
+            map->slots[idx] = *entry;
+            map->size++;
+            return probe + 1;
+        }
+        probe++;
+        group = (group + probe) & mask;
+    }
+    
+}
+
+/*
+ * Move all the entries to the table of the given capacity, hashing them under the current key.
+ */
+static int _msh_map_rebuild(msh_map *map, const size_t capacity, const int rehash) {
+    
+    uint8_t *ctrl = map->ctrl, h2;
+    msh_map_slot *slots = map->slots;
+    size_t old_capacity = map->capacity, probe, i;
+    int result;
+    
+    result = _msh_map_alloc(map, capacity);
+    if (result) {
+        map->ctrl = ctrl;
+        map->slots = slots;
+        return result;
+    }
+    
+    map->max_probe = 0;
+    
+    for (i = 0; i < old_capacity; i++) {
+        if (ctrl[i] & 0x80) continue;
+        h2 = ctrl[i];
+        if (rehash) slots[i].hash = _msh_map_hash(map, slots[i].key, slots[i].key_len, &h2);
+        probe = _msh_map_place(map, &slots[i], h2);
+        if (probe > map->max_probe) map->max_probe = probe;
+    }
+    
+    free(ctrl);
+    free(slots);
+    
+    return 0;
+    
+}
+
+int msh_map_init(msh_map *map, const size_t capacity, msh_map_random_fn random) {
+    
+    uint8_t key[16];
+    
+    map->random = random ? random : msh_map_urandom;
+    map->hash = siphash_with_key;
+    map->max_probe = 0;
+    map->rekeys = 0;
+    map->rekeys_since_grow = 0;
+    
+    if (map->random(key, sizeof(key))) return -1;
+    siphash_key_init(&map->key, key);
+    
+    return _msh_map_alloc(map, capacity);
+    
+}
+
+void msh_map_free(msh_map *map) {
+    free(map->ctrl);
+    free(map->slots);
+    map->ctrl = NULL;
+    map->slots = NULL;
+}
+
+msh_map_slot *msh_map_find(const msh_map *map, const uint8_t *key, const size_t key_len) {
+    
+    size_t mask = map->capacity / MSH_MAP_GROUP - 1, group, probe = 0, idx;
+    uint64_t ctrl, match;
+    uint32_t hash;
+    uint8_t h2;
+    
+    hash = _msh_map_hash(map, key, key_len, &h2);
+    group = hash & mask;
+    
+    /* At most all the groups are visited, the load limit guarantees an empty slot on the way. */
+    for (;;) {
+        ctrl = _msh_map_group(map->ctrl + group * MSH_MAP_GROUP);
+        for (match = _msh_map_match(ctrl, h2); match; match &= match - 1) {
+            idx = group * MSH_MAP_GROUP + _msh_map_first(match);
+            if (map->slots[idx].hash == hash && map->slots[idx].key_len == key_len &&
+                !memcmp(map->slots[idx].key, key, key_len)) {
+                return &map->slots[idx];
+            }
+        }
+        /* Slots are emptied only by a rebuild, so the key can't be past an empty one. */
+        if (_msh_map_match(ctrl, _MSH_EMPTY)) return NULL;
+        probe++;
+        group = (group + probe) & mask;
+    }
+    
+}
+
+int msh_map_insert(msh_map *map, const uint8_t *key, const size_t key_len, void *value) {
+    
+    msh_map_slot entry, *slot;
+    size_t probe;
+    uint8_t h2;
+    int result;
+    
+    slot = msh_map_find(map, key, key_len);
+    if (slot) {
+        slot->value = value;
+        return 1;
+    }
+    
+    if (map->size + map->tombstones + 1 > _MSH_MAX_LOAD(map->capacity)) {
+        /* Drop the tombstones if they take a significant share, grow otherwise. */
+        if (map->tombstones > map->size / 2) result = msh_map_rehash(map, map->size + 1);
+        else result = msh_map_rehash(map, (map->size + 1) * 2);
+        if (result) return result;
+        map->rekeys_since_grow = 0;
+    }
+    
+    entry.key = key;
+    entry.key_len = key_len;
+    entry.value = value;
+    entry.hash = _msh_map_hash(map, key, key_len, &h2);
+    
+    probe = _msh_map_place(map, &entry, h2);
+    if (probe > map->max_probe) map->max_probe = probe;
+    
+    /*
+     * A random key makes long probe sequences very unlikely, so one suggests the key has leaked
+     * or has been guessed. Draw a new one, but only a few times until the table grows again, so
+     * that a poor hash function can't make us rebuild the table on every insert. The entry is in
+     * either way, a failed rekey leaves the map as it was.
+     */
+    if (probe > MSH_MAP_MAX_PROBE && map->rekeys_since_grow < MSH_MAP_MAX_REKEYS) {
+        map->rekeys_since_grow++;
+        msh_map_rekey(map);
+    }
+    
+    return 0;
+    
+}
+
+int msh_map_remove(msh_map *map, const uint8_t *key, const size_t key_len) {
+    
+    msh_map_slot *slot = msh_map_find(map, key, key_len);
+    size_t idx;
+    
+    if (!slot) return -1;
+    
+    idx = (size_t) (slot - map->slots);
+    map->ctrl[idx] = _MSH_DELETED;
+    map->size--;
+    map->tombstones++;
+    
+    return 0;
+    
+}
+
+int msh_map_rehash(msh_map *map, const size_t capacity) {
+    return _msh_map_rebuild(map, capacity < map->size ? map->size : capacity, 0);
+}
+
+int msh_map_rekey(msh_map *map) {
+    
+    siphash_key_t old = map->key;
+    uint8_t key[16];
+    int result;
+    
+    if (map->random(key, sizeof(key))) return -1;
+    siphash_key_init(&map->key, key);
+    
+    /* The entries stay placed under the old key if the table can't be rebuilt. */
+    result = _msh_map_rebuild(map, _MSH_MAX_LOAD(map->capacity), 1);
+    if (result) map->key = old;
+    else map->rekeys++;
+    
+    return result;
+    
+}
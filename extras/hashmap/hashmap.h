@@ -0,0 +1,138 @@
+/*
+ * hashmap.h
+ * Flooding-resistant open-addressing hash map based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ *
+ * Keys are hashed with SipHash under a random per-table key, so an attacker who doesn't know it
+ * can't craft colliding keys. The table is rekeyed whenever a suspiciously long probe sequence shows
+ * up anyway.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+#ifndef _HASHMAP_SIPHASH_H
+#define _HASHMAP_SIPHASH_H
+
+#include "siphash.h"
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of control bytes scanned at once. */
+#define MSH_MAP_GROUP 8
+
+/* Probe sequence length, in groups, which is treated as a sign of an attack. */
+#ifndef MSH_MAP_MAX_PROBE
+#define MSH_MAP_MAX_PROBE 16
+#endif
+
+/* Number of rekeys allowed until the table grows again. */
+#ifndef MSH_MAP_MAX_REKEYS
+#define MSH_MAP_MAX_REKEYS 3
+#endif
+
+/*
+ * Hash function of the table. siphash_with_key() by default, any other of the same signature
+ * (e.g. siphash13_with_key()) can be plugged in after msh_map_init().
+ */
+typedef void (*msh_map_hash_fn)(uint8_t *hash, const uint8_t *data, const size_t len,
+    const siphash_key_t *key);
+
+/*
+ * Source of random keys. Shall fill len bytes under buf and return 0, or non-zero on failure.
+ */
+typedef int (*msh_map_random_fn)(uint8_t *buf, const size_t len);
+
+/*
+ * Keys are not copied, they shall stay valid as long as they are stored in the map.
+ */
+typedef struct {
+    const uint8_t *key;
+    size_t key_len;
+    void *value;
+    uint32_t hash;
+} msh_map_slot;
+
+typedef struct {
+    uint8_t *ctrl;
+    msh_map_slot *slots;
+    size_t capacity;
+    size_t size;
+    size_t tombstones;
+    
+    /* Statistics. */
+    size_t max_probe;
+    unsigned long rekeys;
+    
+    int rekeys_since_grow;
+    siphash_key_t key;
+    msh_map_hash_fn hash;
+    msh_map_random_fn random;
+} msh_map;
+
+/*
+ * Reads the random key from /dev/urandom.
+ */
+int msh_map_urandom(uint8_t *buf, const size_t len);
+
+/*
+ * Initialize the map able to hold capacity entries without growing. If random is NULL,
+ * msh_map_urandom() is used. Returns 0 on success, -1 when the key can't be obtained and -2 when
+ * memory can't be allocated.
+ */
+int msh_map_init(msh_map *map, const size_t capacity, msh_map_random_fn random);
+void msh_map_free(msh_map *map);
+
+/*
+ * Insert or replace the value under the key. Returns 0 if the key was inserted, 1 if replaced and
+ * negative value on failure.
+ */
+int msh_map_insert(msh_map *map, const uint8_t *key, const size_t key_len, void *value);
+
+/*
+ * Returns the slot holding the key, or NULL if there is no such key.
+ */
+msh_map_slot *msh_map_find(const msh_map *map, const uint8_t *key, const size_t key_len);
+
+/*
+ * Returns 0 if the key was removed, -1 if there was no such key.
+ */
+int msh_map_remove(msh_map *map, const uint8_t *key, const size_t key_len);
+
+/*
+ * Rebuild the table for the capacity of at least capacity entries. Clears the tombstones.
+ */
+int msh_map_rehash(msh_map *map, const size_t capacity);
+
+/*
+ * Draw a fresh key and rebuild the table under it. Returns 0 on success, -1 when the key can't be
+ * obtained and -2 when memory can't be allocated, the map being left under the old key.
+ */
+int msh_map_rekey(msh_map *map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * hex.h
+ * Hexadecimal decoding for the mcu-csiphash-2-4 tools
+ * Copyright (c) 2019 Michał Getka
+ *
+ * Parses the keys and the hashes given on the command line and in the checksum files.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+#ifndef _HEX_SIPHASH_H
+#define _HEX_SIPHASH_H
+
+#include "siphash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Decode len bytes from the 2 * len hex digits under hex, of either case. Returns 0 on success and
+ * -1 if any of them is not a hex digit, the contents of out being undefined then.
+ */
+int msh_hex_decode(uint8_t *out, const char *hex, const size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
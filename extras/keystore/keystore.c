@@ -0,0 +1,229 @@
+/*
+ * keystore.c
+ * Lock-free SipHash key rotation based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Epoch-based reclamation. A reader announces the global epoch before it loads the key set
+ * pointer. A rotation swaps the pointer, tags the old set with the epoch and only then advances
+ * the epoch, so any reader which may still hold the old set has announced an epoch not greater
+ * than the tag. Once every reader is either outside of a read or in a later epoch, the set is
+ * wiped and freed.
+ * 
+ * The atomics are the GCC __atomic builtins, all of them sequentially consistent, as the store of
+ * the epoch by a reader shall not be reordered with its load of the pointer.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <string.h>
+#include "keystore.h"
+
+#if !defined(__GNUC__)
+#error "The key store requires the GCC __atomic builtins"
+#endif
+
+#define _MSH_LOAD(p) __atomic_load_n(p, __ATOMIC_SEQ_CST)
+#define _MSH_STORE(p,v) __atomic_store_n(p, v, __ATOMIC_SEQ_CST)
+
+/*
+ * Wipe the keys through a volatile pointer, so the stores can't be dropped before free().
+ */
+static void _msh_wipe(msh_keyset *keys) {
+    volatile uint8_t *p = (volatile uint8_t *) keys;
+    size_t i;
+    for (i = 0; i < sizeof(*keys); i++) p[i] = 0;
+}
+
+static msh_keyset *_msh_keyset_new(const uint8_t *key, const msh_keyset *before) {
+    
+    msh_keyset *keys = malloc(sizeof(msh_keyset));
+    
+    if (!keys) return NULL;
+    
+    memcpy(keys->current_raw, key, 16);
+    siphash_key_init(&keys->current, key);
+    
+    if (before) {
+        memcpy(keys->previous_raw, before->current_raw, 16);
+        keys->previous = before->current;
+        keys->version = before->version + 1;
+    } else {
+        memcpy(keys->previous_raw, key, 16);
+        keys->previous = keys->current;
+        keys->version = 1;
+    }
+    
+    keys->next = NULL;
+    keys->retired = 0;
+    
+    return keys;
+    
+}
+
+int msh_keystore_init(msh_keystore *store, const uint8_t *key) {
+    
+    void *readers;
+    
+    /* The store itself may be anywhere, the slots are aligned on their own. */
+    if (posix_memalign(&readers, MSH_KEYSTORE_LINE, MSH_KEYSTORE_READERS *
+        sizeof(msh_keystore_reader))) return -2;
+    store->readers = (msh_keystore_reader *) readers;
+    memset(store->readers, 0, MSH_KEYSTORE_READERS * sizeof(msh_keystore_reader));
+    
+    store->epoch = 1;
+    store->retired = NULL;
+    store->keys = _msh_keyset_new(key, NULL);
+    
+    if (!store->keys || pthread_mutex_init(&store->lock, NULL)) {
+        free(store->keys);
+        free(store->readers);
+        return -2;
+    }
+    
+    return 0;
+    
+}
+
+void msh_keystore_free(msh_keystore *store) {
+    
+    msh_keyset *keys, *next;
+    
+    for (keys = store->retired; keys; keys = next) {
+        next = keys->next;
+        _msh_wipe(keys);
+        free(keys);
+    }
+    
+    _msh_wipe(store->keys);
+    free(store->keys);
+    store->keys = NULL;
+    store->retired = NULL;
+    free(store->readers);
+    store->readers = NULL;
+    pthread_mutex_destroy(&store->lock);
+    
+}
+
+msh_keystore_reader *msh_keystore_register(msh_keystore *store) {
+    
+    int i, expected;
+    
+    for (i = 0; i < MSH_KEYSTORE_READERS; i++) {
+        expected = 0;
+        if (__atomic_compare_exchange_n(&store->readers[i].used, &expected, 1, 0, __ATOMIC_SEQ_CST,
+            __ATOMIC_SEQ_CST)) {
+            _MSH_STORE(&store->readers[i].epoch, 0UL);
+            return &store->readers[i];
+        }
+    }
+    
+    return NULL;
+    
+}
+
+void msh_keystore_unregister(msh_keystore_reader *reader) {
+    _MSH_STORE(&reader->epoch, 0UL);
+    _MSH_STORE(&reader->used, 0);
+}
+
+const msh_keyset *msh_keystore_enter(msh_keystore *store, msh_keystore_reader *reader) {
+    _MSH_STORE(&reader->epoch, _MSH_LOAD(&store->epoch));
+    return _MSH_LOAD(&store->keys);
+}
+
+void msh_keystore_exit(msh_keystore_reader *reader) {
+    __atomic_store_n(&reader->epoch, 0UL, __ATOMIC_RELEASE);
+}
+
+/*
+ * Shall be called with the lock held.
+ */
+static size_t _msh_keystore_reclaim(msh_keystore *store) {
+    
+    msh_keyset **link = &store->retired, *keys;
+    unsigned long oldest = 0, epoch;
+    size_t left = 0;
+    int i;
+    
+    /* The oldest epoch any reader is in. */
+    for (i = 0; i < MSH_KEYSTORE_READERS; i++) {
+        epoch = _MSH_LOAD(&store->readers[i].epoch);
+        if (epoch && (!oldest || epoch < oldest)) oldest = epoch;
+    }
+    
+    while ((keys = *link)) {
+        if (!oldest || keys->retired < oldest) {
+            *link = keys->next;
+            _msh_wipe(keys);
+            free(keys);
+        } else {
+            link = &keys->next;
+            left++;
+        }
+    }
+    
+    return left;
+    
+}
+
+int msh_keystore_rotate(msh_keystore *store, const uint8_t *key) {
+    
+    msh_keyset *keys, *old;
+    
+    pthread_mutex_lock(&store->lock);
+    
+    old = store->keys;
+    keys = _msh_keyset_new(key, old);
+    if (!keys) {
+        pthread_mutex_unlock(&store->lock);
+        return -2;
+    }
+    
+    _MSH_STORE(&store->keys, keys);
+    old->retired = store->epoch;
+    old->next = store->retired;
+    store->retired = old;
+    _MSH_STORE(&store->epoch, store->epoch + 1);
+    
+    _msh_keystore_reclaim(store);
+    
+    pthread_mutex_unlock(&store->lock);
+    
+    return 0;
+    
+}
+
+size_t msh_keystore_reclaim(msh_keystore *store) {
+    
+    size_t left;
+    
+    pthread_mutex_lock(&store->lock);
+    left = _msh_keystore_reclaim(store);
+    pthread_mutex_unlock(&store->lock);
+    
+    return left;
+    
+}
@@ -0,0 +1,129 @@
+/*
+ * keystore.h
+ * Lock-free SipHash key rotation based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ *
+ * The current key set is published behind an atomic pointer. Readers pin it by announcing the
+ * epoch they run in, without locks or allocation; key sets replaced by a rotation are wiped and
+ * freed once no reader can still use them.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+#ifndef _KEYSTORE_SIPHASH_H
+#define _KEYSTORE_SIPHASH_H
+
+#include "siphash.h"
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Maximal number of registered readers. */
+#ifndef MSH_KEYSTORE_READERS
+#define MSH_KEYSTORE_READERS 128
+#endif
+
+/*
+ * Keys valid in a single period. The previous key is the current key of the period before, kept
+ * for verifying what was produced before the rotation; in the first period both are the same.
+ */
+typedef struct msh_keyset {
+    siphash_key_t current;
+    siphash_key_t previous;
+    uint8_t current_raw[16];
+    uint8_t previous_raw[16];
+    /* Number of the period, starting at 1. */
+    unsigned long version;
+    /* Reclamation, private to the store. */
+    struct msh_keyset *next;
+    unsigned long retired;
+} msh_keyset;
+
+/* Cache line size the reader slots are laid out for. */
+#ifndef MSH_KEYSTORE_LINE
+#define MSH_KEYSTORE_LINE 64
+#endif
+
+/*
+ * Epoch announced by a reader, 0 when it is outside of any read. Padded to a cache line, and the
+ * slots are allocated aligned to one, so every reader has a line of its own.
+ */
+typedef struct {
+    unsigned long epoch;
+    int used;
+    char pad[MSH_KEYSTORE_LINE - sizeof(unsigned long) - sizeof(int)];
+} msh_keystore_reader;
+
+typedef struct {
+    msh_keyset *keys;
+    unsigned long epoch;
+    /* MSH_KEYSTORE_READERS slots. */
+    msh_keystore_reader *readers;
+    /* Serializes the writers, never taken by the readers. */
+    pthread_mutex_t lock;
+    msh_keyset *retired;
+} msh_keystore;
+
+/*
+ * Initialize the store with the first 16 byte key. Returns 0 on success, -2 when memory can't be
+ * allocated.
+ */
+int msh_keystore_init(msh_keystore *store, const uint8_t *key);
+
+/*
+ * Free the store and all the key sets. No reader may be inside a read.
+ */
+void msh_keystore_free(msh_keystore *store);
+
+/*
+ * Register the calling thread as a reader. Returns the reader to pass to msh_keystore_enter() and
+ * msh_keystore_exit(), or NULL if all MSH_KEYSTORE_READERS are taken. A reader shall be used by a
+ * single thread at a time.
+ */
+msh_keystore_reader *msh_keystore_register(msh_keystore *store);
+void msh_keystore_unregister(msh_keystore_reader *reader);
+
+/*
+ * Pin the current key set. It stays valid until msh_keystore_exit(), rotations in the meantime
+ * notwithstanding. Reads shall not be nested.
+ */
+const msh_keyset *msh_keystore_enter(msh_keystore *store, msh_keystore_reader *reader);
+void msh_keystore_exit(msh_keystore_reader *reader);
+
+/*
+ * Publish the new 16 byte key, the current one becoming the previous one, and reclaim the key sets
+ * no reader uses anymore. Returns 0 on success, -2 when memory can't be allocated.
+ */
+int msh_keystore_rotate(msh_keystore *store, const uint8_t *key);
+
+/*
+ * Reclaim the retired key sets no reader uses anymore. Returns the number of the ones left.
+ */
+size_t msh_keystore_reclaim(msh_keystore *store);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ * mac.c
+ * Batched packet authentication based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * The ring is processed in chunks of SIPHASH_MAC_CHUNK packets. Before a chunk is hashed, the
+ * first lines of the packets of the next one are prefetched, so their cache misses overlap with
+ * the hashing. Tags are compared by accumulating the differences of all their bytes, and the
+ * result is turned into a bit without branching.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include "mac.h"
+#include "siphash_batch.h"
+
+#if defined(__GNUC__)
+#define _MSH_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define _MSH_PREFETCH(p) ((void) 0)
+#endif
+
+/* Bytes of every packet prefetched ahead, also the tag is. */
+#define _MSH_MAC_AHEAD 128
+
+/*
+ * Gather the pointers and lengths of the chunk of cnt packets starting at the ring index idx, and
+ * prefetch the chunk which follows it.
+ */
+static void _msh_mac_gather(const siphash_mac_desc *ring, const size_t size, size_t idx,
+    const size_t cnt, const size_t next, const uint8_t **datas, size_t *lens) {
+    
+    const siphash_mac_desc *d;
+    size_t i, j, ahead = idx + cnt;
+    
+    for (i = 0; i < cnt; i++, idx++) {
+        if (idx == size) idx = 0;
+        datas[i] = ring[idx].data;
+        lens[i] = ring[idx].len;
+    }
+    
+    for (i = 0; i < next; i++, ahead++) {
+        d = &ring[ahead % size];
+        for (j = 0; j < d->len && j < _MSH_MAC_AHEAD; j += 64) _MSH_PREFETCH(d->data + j);
+        _MSH_PREFETCH(d->data + d->tag_off);
+    }
+    
+}
+
+int siphash_mac_equal(const uint8_t *tag, const uint8_t *expected) {
+    
+    uint32_t diff = 0;
+    int i;
+    
+    for (i = 0; i < SIPHASH_MAC_TAG; i++) diff |= (uint32_t) (tag[i] ^ expected[i]);
+    
+    /* diff - 1 borrows into the upper bits only if diff is zero. */
+    return (int) (((diff - 1) >> 8) & 1);
+    
+}
+
+void siphash_mac_sign_batch(siphash_mac_desc *ring, const size_t size, const size_t head,
+    const size_t n, const uint8_t *key) {
+    
+    const uint8_t *datas[SIPHASH_MAC_CHUNK];
+    uint8_t tags[SIPHASH_MAC_TAG * SIPHASH_MAC_CHUNK];
+    size_t lens[SIPHASH_MAC_CHUNK], i, j, cnt, next, idx;
+    
+    for (i = 0; i < n; i += cnt) {
+        cnt = n - i < SIPHASH_MAC_CHUNK ? n - i : SIPHASH_MAC_CHUNK;
+        next = n - i - cnt < SIPHASH_MAC_CHUNK ? n - i - cnt : SIPHASH_MAC_CHUNK;
+        _msh_mac_gather(ring, size, (head + i) % size, cnt, next, datas, lens);
+        siphash_batch(tags, datas, lens, cnt, key);
+        for (j = 0; j < cnt; j++) {
+            idx = (head + i + j) % size;
+            memcpy(ring[idx].data + ring[idx].tag_off, tags + SIPHASH_MAC_TAG * j, SIPHASH_MAC_TAG);
+        }
+    }
+    
+}
+
+size_t siphash_mac_verify_batch(const siphash_mac_desc *ring, const size_t size, const size_t head,
+    const size_t n, const uint8_t *key, uint8_t *bitmap) {
+    
+    const uint8_t *datas[SIPHASH_MAC_CHUNK];
+    uint8_t tags[SIPHASH_MAC_TAG * SIPHASH_MAC_CHUNK];
+    size_t lens[SIPHASH_MAC_CHUNK], i, j, cnt, next, idx, passed = 0;
+    int pass;
+    
+    memset(bitmap, 0, (n + 7) / 8);
+    
+    for (i = 0; i < n; i += cnt) {
+        cnt = n - i < SIPHASH_MAC_CHUNK ? n - i : SIPHASH_MAC_CHUNK;
+        next = n - i - cnt < SIPHASH_MAC_CHUNK ? n - i - cnt : SIPHASH_MAC_CHUNK;
+        _msh_mac_gather(ring, size, (head + i) % size, cnt, next, datas, lens);
+        siphash_batch(tags, datas, lens, cnt, key);
+        for (j = 0; j < cnt; j++) {
+            idx = (head + i + j) % size;
+            pass = siphash_mac_equal(ring[idx].data + ring[idx].tag_off, tags + SIPHASH_MAC_TAG * j);
+            bitmap[(i + j) >> 3] |= (uint8_t) (pass << ((i + j) & 7));
+            passed += (size_t) pass;
+        }
+    }
+    
+    return passed;
+    
+}
@@ -0,0 +1,81 @@
+/*
+ * mac.h
+ * Batched packet authentication based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ *
+ * Signs and verifies rings of packets with 8 byte SipHash-2-4 tags, hashing them across the SIMD
+ * lanes of siphash_batch() and comparing the tags in constant time.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+#ifndef _MAC_SIPHASH_H
+#define _MAC_SIPHASH_H
+
+#include "siphash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIPHASH_MAC_TAG 8
+
+/* Number of packets hashed at once, the packets of the next chunk being prefetched meanwhile. */
+#ifndef SIPHASH_MAC_CHUNK
+#define SIPHASH_MAC_CHUNK 16
+#endif
+
+/*
+ * Packet descriptor. The tag authenticates the len bytes under data and is stored under
+ * data + tag_off, which shall not overlap them (tag_off >= len for a trailing tag).
+ */
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t tag_off;
+} siphash_mac_desc;
+
+/*
+ * Sign n packets of the ring of size descriptors, starting at head and wrapping around, under the
+ * 16 byte key. The tag of each packet is stored at its tag_off.
+ */
+void siphash_mac_sign_batch(siphash_mac_desc *ring, const size_t size, const size_t head,
+    const size_t n, const uint8_t *key);
+
+/*
+ * Verify n packets of the ring the same way. Bit i % 8 of bitmap[i / 8] is set if the i-th packet
+ * passed and cleared otherwise, the bitmap shall hold (n + 7) / 8 bytes. Returns the number of
+ * packets which passed. The running time doesn't depend on the tags.
+ */
+size_t siphash_mac_verify_batch(const siphash_mac_desc *ring, const size_t size, const size_t head,
+    const size_t n, const uint8_t *key, uint8_t *bitmap);
+
+/*
+ * Returns 1 if the tags are equal and 0 otherwise, in constant time.
+ */
+int siphash_mac_equal(const uint8_t *tag, const uint8_t *expected);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
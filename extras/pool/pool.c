@@ -0,0 +1,160 @@
+/*
+ * pool.c
+ * Worker thread pool for the mcu-csiphash-2-4 extras
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Tasks are handed out one at a time under the pool lock, so they shall be coarse enough for the
+ * locking not to matter, e.g. chunks of a batch or whole files.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <unistd.h>
+#include "pool.h"
+
+/*
+ * Runs tasks of the current loop until there are none left. Called with the lock held, returns
+ * with the lock held.
+ */
+static void _msh_pool_work(msh_pool *pool) {
+    
+    size_t task;
+    
+    while (pool->next < pool->tasks) {
+        task = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        pool->fn(pool->arg, task);
+        pthread_mutex_lock(&pool->lock);
+        if (++pool->finished == pool->tasks) pthread_cond_broadcast(&pool->done);
+    }
+    
+}
+
+static void *_msh_pool_worker(void *arg) {
+    
+    msh_pool *pool = (msh_pool *) arg;
+    unsigned long seen = 0;
+    
+    pthread_mutex_lock(&pool->lock);
+    
+    for (;;) {
+        while (!pool->stop && pool->generation == seen) pthread_cond_wait(&pool->work, &pool->lock);
+        if (pool->stop) break;
+        seen = pool->generation;
+        _msh_pool_work(pool);
+    }
+    
+    pthread_mutex_unlock(&pool->lock);
+    
+    return NULL;
+    
+}
+
+int msh_pool_cpus(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int) cpus : 1;
+}
+
+int msh_pool_init(msh_pool *pool, const int threads) {
+    
+    int i;
+    
+    pool->workers = 0;
+    pool->threads = NULL;
+    pool->tasks = pool->next = pool->finished = 0;
+    pool->generation = 0;
+    pool->stop = 0;
+    
+    if (pthread_mutex_init(&pool->lock, NULL)) return -1;
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    
+    if (threads > 1) {
+        pool->threads = malloc(sizeof(pthread_t) * (threads - 1));
+        if (!pool->threads) {
+            msh_pool_free(pool);
+            return -1;
+        }
+    }
+    
+    for (i = 0; i < threads - 1; i++) {
+        if (pthread_create(&pool->threads[i], NULL, _msh_pool_worker, pool)) {
+            msh_pool_free(pool);
+            return -1;
+        }
+        pool->workers++;
+    }
+    
+    return 0;
+    
+}
+
+void msh_pool_run(msh_pool *pool, msh_pool_fn fn, void *arg, const size_t tasks) {
+    
+    size_t i;
+    
+    if (!pool->workers || tasks < 2) {
+        for (i = 0; i < tasks; i++) fn(arg, i);
+        return;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->tasks = tasks;
+    pool->next = 0;
+    pool->finished = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work);
+    
+    _msh_pool_work(pool);
+    while (pool->finished < pool->tasks) pthread_cond_wait(&pool->done, &pool->lock);
+    
+    pthread_mutex_unlock(&pool->lock);
+    
+}
+
+void msh_pool_free(msh_pool *pool) {
+    
+    int i;
+    
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    
+    for (i = 0; i < pool->workers; i++) pthread_join(pool->threads[i], NULL);
+    
+    free(pool->threads);
+    pool->threads = NULL;
+    pool->workers = 0;
+    
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+    pthread_mutex_destroy(&pool->lock);
+    
+}
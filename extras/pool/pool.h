@@ -0,0 +1,84 @@
+/*
+ * pool.h
+ * Worker thread pool for the mcu-csiphash-2-4 extras
+ * Copyright (c) 2019 Michał Getka
+ *
+ * A minimal POSIX threads pool running parallel loops: the tasks 0..n-1 are handed out to the
+ * workers and the calling thread, which returns once all of them are done.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+#ifndef _POOL_SIPHASH_H
+#define _POOL_SIPHASH_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*msh_pool_fn)(void *arg, size_t task);
+
+typedef struct {
+    pthread_t *threads;
+    int workers;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    /* The loop being run. */
+    msh_pool_fn fn;
+    void *arg;
+    size_t tasks;
+    size_t next;
+    size_t finished;
+    unsigned long generation;
+    int stop;
+} msh_pool;
+
+/*
+ * Number of online CPUs, at least 1.
+ */
+int msh_pool_cpus(void);
+
+/*
+ * Start threads - 1 workers, the calling thread being the last one. Returns 0 on success.
+ */
+int msh_pool_init(msh_pool *pool, const int threads);
+
+/*
+ * Run fn(arg, i) for every i < tasks and wait for all of them to finish. Loops of a single pool
+ * shall not be run concurrently, nor nested.
+ */
+void msh_pool_run(msh_pool *pool, msh_pool_fn fn, void *arg, const size_t tasks);
+
+/*
+ * Stop and join the workers.
+ */
+void msh_pool_free(msh_pool *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
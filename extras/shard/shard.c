@@ -0,0 +1,170 @@
+/*
+ * shard.c
+ * Keyed shard routing based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * The node keys are derived as siphash128() of the little-endian node id under the routing key,
+ * and prepared once when the node is added. Weights are compared as little-endian 64-bit integers,
+ * ties going to the higher id so the result doesn't depend on the order of the nodes.
+ * 
+ * This implementation utilizes dynamically allocated buffers.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include "shard.h"
+
+static uint64_t _msh_load64(const uint8_t *p) {
+    uint64_t v = 0;
+    int i;
+    for (i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static void _msh_store64(uint8_t *p, uint64_t v) {
+    int i;
+    for (i = 0; i < 8; i++, v >>= 8) p[i] = (uint8_t) v;
+}
+
+int32_t msh_jump_hash(uint64_t h, const int32_t buckets) {
+    
+    int64_t b = -1, j = 0;
+    
+    if (buckets <= 0) return -1;
+    
+    while (j < buckets) {
+        b = j;
+        h = h * UINT64_C(2862933555777941757) + 1;
+        j = (int64_t) ((b + 1) * (2147483648.0 / (double) ((h >> 33) + 1)));
+    }
+    
+    return (int32_t) b;
+    
+}
+
+int32_t msh_jump(const uint8_t *item, const size_t len, const siphash_key_t *key,
+    const int32_t buckets) {
+    
+    uint8_t hash[8];
+    
+    siphash_with_key(hash, item, len, key);
+    
+    return msh_jump_hash(_msh_load64(hash), buckets);
+    
+}
+
+int msh_hrw_init(msh_hrw *hrw, const uint8_t *key) {
+    
+    hrw->ids = NULL;
+    hrw->keys = NULL;
+    hrw->count = 0;
+    hrw->capacity = 0;
+    memcpy(hrw->raw_key, key, 16);
+    siphash_key_init(&hrw->key, key);
+    
+    return 0;
+    
+}
+
+void msh_hrw_free(msh_hrw *hrw) {
+    free(hrw->ids);
+    free(hrw->keys);
+    hrw->ids = NULL;
+    hrw->keys = NULL;
+    hrw->count = hrw->capacity = 0;
+}
+
+int msh_hrw_add(msh_hrw *hrw, const uint64_t id) {
+    
+    uint8_t id_bytes[8], node_key[16];
+    uint64_t *ids;
+    siphash_key_t *keys;
+    size_t i, capacity;
+    
+    for (i = 0; i < hrw->count; i++) {
+        if (hrw->ids[i] == id) return -1;
+    }
+    
+    if (hrw->count == hrw->capacity) {
+        capacity = hrw->capacity ? hrw->capacity * 2 : 16;
+        ids = realloc(hrw->ids, capacity * sizeof(*ids));
+        if (!ids) return -2;
+        hrw->ids = ids;
+        keys = realloc(hrw->keys, capacity * sizeof(*keys));
+        if (!keys) return -2;
+        hrw->keys = keys;
+        hrw->capacity = capacity;
+    }
+    
+    _msh_store64(id_bytes, id);
+    siphash128(node_key, id_bytes, 8, hrw->raw_key);
+    
+    hrw->ids[hrw->count] = id;
+    siphash_key_init(&hrw->keys[hrw->count], node_key);
+    hrw->count++;
+    
+    return 0;
+    
+}
+
+int msh_hrw_remove(msh_hrw *hrw, const uint64_t id) {
+    
+    size_t i;
+    
+    for (i = 0; i < hrw->count; i++) {
+        if (hrw->ids[i] == id) {
+            hrw->count--;
+            hrw->ids[i] = hrw->ids[hrw->count];
+            hrw->keys[i] = hrw->keys[hrw->count];
+            return 0;
+        }
+    }
+    
+    return -1;
+    
+}
+
+int msh_hrw_route(const msh_hrw *hrw, const uint8_t *item, const size_t len, uint64_t *id) {
+    
+    uint8_t hash[8], weight[8];
+    uint64_t w, best = 0;
+    size_t i, winner = 0;
+    
+    if (!hrw->count) return -1;
+    
+    siphash_with_key(hash, item, len, &hrw->key);
+    
+    for (i = 0; i < hrw->count; i++) {
+        siphash_u64(weight, hash, &hrw->keys[i]);
+        w = _msh_load64(weight);
+        if (i == 0 || w > best || (w == best && hrw->ids[i] > hrw->ids[winner])) {
+            best = w;
+            winner = i;
+        }
+    }
+    
+    *id = hrw->ids[winner];
+    
+    return 0;
+    
+}
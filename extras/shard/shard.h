@@ -0,0 +1,97 @@
+/*
+ * shard.h
+ * Keyed shard routing based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ *
+ * Items are routed by their SipHash under a secret key, so clients who don't know it can't pick
+ * items landing on the same shard. Jump consistent hashing suits shards numbered 0..n-1 which are
+ * only added or removed at the end, rendezvous hashing any set of nodes.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+#ifndef _SHARD_SIPHASH_H
+#define _SHARD_SIPHASH_H
+
+#include "siphash.h"
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Jump consistent hash (Lamping and Veach) of the 64-bit hash h into buckets buckets. Growing the
+ * number of buckets from n to n + 1 moves only 1 / (n + 1) of the hashes, all of them to the new
+ * bucket. Returns -1 if buckets is not positive.
+ */
+int32_t msh_jump_hash(uint64_t h, const int32_t buckets);
+
+/*
+ * Bucket of the item, jump consistent hash seeded from its siphash_with_key() under the key.
+ */
+int32_t msh_jump(const uint8_t *item, const size_t len, const siphash_key_t *key,
+    const int32_t buckets);
+
+/*
+ * Rendezvous (highest random weight) hashing over a set of nodes identified by 64-bit ids. Every
+ * node holds a prepared key derived from the routing key and its id, the weight of the node for an
+ * item being siphash_u64() of the item hash under it, so routing costs one hash of the item and one
+ * fixed length hash per node.
+ */
+typedef struct {
+    uint64_t *ids;
+    siphash_key_t *keys;
+    size_t count;
+    size_t capacity;
+    uint8_t raw_key[16];
+    siphash_key_t key;
+} msh_hrw;
+
+/*
+ * Initialize the empty set of nodes routed under the 16 byte key. Returns 0.
+ */
+int msh_hrw_init(msh_hrw *hrw, const uint8_t *key);
+void msh_hrw_free(msh_hrw *hrw);
+
+/*
+ * Add the node. Returns 0 on success, -1 if the node is present already and -2 when memory can't
+ * be allocated.
+ */
+int msh_hrw_add(msh_hrw *hrw, const uint64_t id);
+
+/*
+ * Returns 0 if the node was removed, -1 if there was no such node.
+ */
+int msh_hrw_remove(msh_hrw *hrw, const uint64_t id);
+
+/*
+ * Store the id of the node the item is routed to under id. Returns 0, or -1 if there are no nodes.
+ * Only the items of a removed node, or the ones won by an added node, change their node.
+ */
+int msh_hrw_route(const msh_hrw *hrw, const uint8_t *item, const size_t len, uint64_t *id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
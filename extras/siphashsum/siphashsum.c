@@ -0,0 +1,402 @@
+/*
+ * siphashsum.c
+ * Keyed file fingerprints based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Prints or checks SipHash-2-4 sums of files in the sha256sum format. Regular files are mapped
+ * into memory a window at a time, other inputs are read in large blocks, and both are hashed
+ * incrementally, so the inputs never have to fit in memory. Files are hashed concurrently across
+ * a thread pool.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "siphash.h"
+#include "pool.h"
+#include "hex.h"
+
+/* Size of a single mapping of a regular file, a multiple of the page size. */
+#ifndef SUM_WINDOW
+#define SUM_WINDOW ((size_t) 64 << 20)
+#endif
+
+/* Size of the reads from pipes and other non-mappable inputs. */
+#ifndef SUM_BLOCK
+#define SUM_BLOCK ((size_t) 1 << 20)
+#endif
+
+#define SUM_LINE 4096
+
+/* Storage class of the per-thread fault recovery point. */
+#ifndef SUM_THREAD_LOCAL
+#define SUM_THREAD_LOCAL __thread
+#endif
+
+/* Returned by hash_mapped() when the file shrank under the mapping. */
+#define SUM_TRUNCATED -2
+
+typedef struct {
+    char *name;
+    uint8_t hash[8];
+    uint8_t expected[8];
+    int error;
+} sum_file;
+
+typedef struct {
+    sum_file *files;
+    siphash_key_t key;
+    
+    /* Set while the entries of the standard input are hashed, serially after the pool. */
+    int standard_input;
+} sum_job;
+
+static const char *program = "siphashsum";
+
+/* Recovery point of the window being hashed by the thread, NULL outside of hash_window(). */
+static SUM_THREAD_LOCAL sigjmp_buf *sum_fault;
+
+/*
+ * Touching a mapping past the end of a file truncated meanwhile raises SIGBUS. The thread hashing
+ * it bails out, any other fault kills the process as it would without the handler.
+ */
+static void sum_sigbus(int sig) {
+    if (sum_fault) siglongjmp(*sum_fault, 1);
+    signal(sig, SIG_DFL);
+}
+
+/*
+ * Hashes the mapped window, returns -1 if it couldn't be read. The mask is restored along with the
+ * registers, SIGBUS being blocked while the handler runs.
+ */
+static int hash_window(siphash_ctx *ctx, const uint8_t *p, const size_t len) {
+    
+    sigjmp_buf fault;
+    
+    if (sigsetjmp(fault, 1)) {
+        sum_fault = NULL;
+        return -1;
+    }
+    
+    sum_fault = &fault;
+    siphash_update(ctx, p, len);
+    sum_fault = NULL;
+    
+    return 0;
+    
+}
+
+/*
+ * Hashes the file from start to size. The mappings begin at page boundaries, the first one possibly
+ * before start, as the offset of an inherited descriptor may be anywhere. Returns SUM_TRUNCATED if
+ * the file turned out shorter than size.
+ */
+static int hash_mapped(siphash_ctx *ctx, const int fd, const off_t start, const off_t size) {
+    
+    off_t offset, base, page = (off_t) sysconf(_SC_PAGESIZE);
+    size_t len, skip;
+    uint8_t *p;
+    
+    if (page <= 0) return -1;
+    
+    for (offset = start; offset < size; offset += (off_t) len) {
+        base = offset - offset % page;
+        skip = (size_t) (offset - base);
+        len = SUM_WINDOW - skip;
+        if (size - offset < (off_t) len) len = (size_t) (size - offset);
+        p = mmap(NULL, skip + len, PROT_READ, MAP_PRIVATE, fd, base);
+        if (p == MAP_FAILED) return -1;
+        madvise(p, skip + len, MADV_SEQUENTIAL);
+        if (hash_window(ctx, p + skip, len)) {
+            munmap(p, skip + len);
+            return SUM_TRUNCATED;
+        }
+        munmap(p, skip + len);
+    }
+    
+    return 0;
+    
+}
+
+static int hash_stream(siphash_ctx *ctx, const int fd) {
+    
+    uint8_t *buffer;
+    ssize_t n;
+    
+    buffer = malloc(SUM_BLOCK);
+    if (!buffer) return -1;
+    
+    for (;;) {
+        n = read(fd, buffer, SUM_BLOCK);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        siphash_update(ctx, buffer, (size_t) n);
+    }
+    
+    free(buffer);
+    
+    return n < 0 ? -1 : 0;
+    
+}
+
+/*
+ * Hashes a single file, "-" being the standard input. Runs on the pool, skipping the standard input,
+ * which can be read by one thread only and is left to the serial pass.
+ */
+static void hash_file(void *arg, size_t task) {
+    
+    sum_job *job = (sum_job *) arg;
+    sum_file *file = job->files + task;
+    siphash_ctx ctx;
+    struct stat st;
+    off_t start = 0;
+    int fd, regular, mapped;
+    
+    if (!strcmp(file->name, "-") != job->standard_input) return;
+    
+    fd = job->standard_input ? STDIN_FILENO : open(file->name, O_RDONLY);
+    if (fd < 0) {
+        file->error = errno;
+        return;
+    }
+    
+    /* The standard input may be a regular file already read in part, hash from where it is. */
+    regular = !fstat(fd, &st) && S_ISREG(st.st_mode) && (start = lseek(fd, 0, SEEK_CUR)) >= 0;
+    
+    siphash_init_with_key(&ctx, &job->key);
+    
+    /* Fall back to reading if the file can't be mapped after all. A truncated one is a read error. */
+    mapped = regular ? hash_mapped(&ctx, fd, start, st.st_size) : -1;
+    if (mapped == SUM_TRUNCATED) {
+        file->error = EIO;
+    } else if (!mapped) {
+        /* Consumed like read, so that the standard input given again reads as empty. */
+        if (fd == STDIN_FILENO && lseek(fd, st.st_size, SEEK_SET) < 0) file->error = errno;
+    } else {
+        siphash_init_with_key(&ctx, &job->key);
+        if (regular && lseek(fd, start, SEEK_SET) < 0) file->error = errno;
+        else if (hash_stream(&ctx, fd)) file->error = errno;
+    }
+    
+    siphash_final(&ctx, file->hash);
+    
+    if (fd != STDIN_FILENO) close(fd);
+    
+}
+
+/*
+ * Reads "<hash>  <name>" lines of the check file, returns the number of entries or -1.
+ */
+static long read_checks(FILE *in, const char *list, sum_file **files, long count, long *malformed) {
+    
+    char line[SUM_LINE];
+    sum_file *grown;
+    size_t len;
+    
+    while (fgets(line, sizeof(line), in)) {
+        
+        len = strlen(line);
+        while (len && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = 0;
+        if (!len) continue;
+        
+        /* Two spaces, or a space and the binary mode marker. */
+        if (len < 19 || line[16] != ' ' || (line[17] != ' ' && line[17] != '*')) {
+            (*malformed)++;
+            continue;
+        }
+        
+        grown = realloc(*files, sizeof(sum_file) * (count + 1));
+        if (!grown) return -1;
+        *files = grown;
+        
+        if (msh_hex_decode(grown[count].expected, line, 8)) {
+            (*malformed)++;
+            continue;
+        }
+        
+        grown[count].name = malloc(len - 17);
+        if (!grown[count].name) return -1;
+        memcpy(grown[count].name, line + 18, len - 17);
+        grown[count].error = 0;
+        count++;
+        
+    }
+    
+    if (ferror(in)) {
+        fprintf(stderr, "%s: %s: read error\n", program, list);
+        return -1;
+    }
+    
+    return count;
+    
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: %s -k KEY [-c] [-j THREADS] [FILE]...\n"
+        "Print or check SipHash-2-4 sums under the 16 byte KEY given as 32 hex digits.\n"
+        "With no FILE, or when FILE is -, read the standard input.\n\n"
+        "  -k, --key KEY     hash key\n"
+        "  -c, --check       read sums from the FILEs and check them\n"
+        "  -j, --jobs N      hash up to N files concurrently\n", program);
+}
+
+int main(int argc, char **argv) {
+    
+    char *stdin_name = "-";
+    const char *key_hex = NULL;
+    uint8_t key[16];
+    sum_file *files = NULL;
+    sum_job job;
+    msh_pool pool;
+    struct sigaction bus;
+    long count = 0, failed = 0, unreadable = 0, malformed = 0, i;
+    int check = 0, threads = msh_pool_cpus(), names = 0, status = 0, arg;
+    FILE *in;
+    
+    for (arg = 1; arg < argc; arg++) {
+        if (!strcmp(argv[arg], "-k") || !strcmp(argv[arg], "--key")) {
+            if (++arg == argc) break;
+            key_hex = argv[arg];
+        } else if (!strcmp(argv[arg], "-j") || !strcmp(argv[arg], "--jobs")) {
+            if (++arg == argc) break;
+            threads = atoi(argv[arg]);
+        } else if (!strcmp(argv[arg], "-c") || !strcmp(argv[arg], "--check")) {
+            check = 1;
+        } else if (!strcmp(argv[arg], "-h") || !strcmp(argv[arg], "--help")) {
+            usage();
+            return 0;
+        } else if (!strcmp(argv[arg], "--")) {
+            arg++;
+            break;
+        } else if (argv[arg][0] == '-' && argv[arg][1]) {
+            usage();
+            return 2;
+        } else {
+            break;
+        }
+    }
+    
+    if (!key_hex || strlen(key_hex) != 32 || msh_hex_decode(key, key_hex, 16) || threads < 1) {
+        usage();
+        return 2;
+    }
+    
+    if (arg == argc) {
+        argv = &stdin_name;
+        argc = 1;
+        arg = 0;
+    }
+    names = argc - arg;
+    
+    if (check) {
+        for (; arg < argc; arg++) {
+            in = strcmp(argv[arg], "-") ? fopen(argv[arg], "r") : stdin;
+            if (!in) {
+                fprintf(stderr, "%s: %s: %s\n", program, argv[arg], strerror(errno));
+                status = 1;
+                continue;
+            }
+            count = read_checks(in, argv[arg], &files, count, &malformed);
+            if (in != stdin) fclose(in);
+            if (count < 0) return 1;
+        }
+    } else {
+        files = malloc(sizeof(sum_file) * names);
+        if (!files) return 1;
+        for (; arg < argc; arg++, count++) {
+            files[count].name = argv[arg];
+            files[count].error = 0;
+        }
+    }
+    
+    siphash_key_init(&job.key, key);
+    job.files = files;
+    job.standard_input = 0;
+    
+    memset(&bus, 0, sizeof(bus));
+    bus.sa_handler = sum_sigbus;
+    sigemptyset(&bus.sa_mask);
+    sigaction(SIGBUS, &bus, NULL);
+    
+    if (threads > count) threads = count > 0 ? (int) count : 1;
+    if (msh_pool_init(&pool, threads)) return 1;
+    msh_pool_run(&pool, hash_file, &job, (size_t) count);
+    msh_pool_free(&pool);
+    
+    /* The standard input, given any number of times, is read in the order of the arguments. */
+    job.standard_input = 1;
+    for (i = 0; i < count; i++) hash_file(&job, (size_t) i);
+    
+    for (i = 0; i < count; i++) {
+        if (files[i].error) {
+            fprintf(stderr, "%s: %s: %s\n", program, files[i].name, strerror(files[i].error));
+            if (check) printf("%s: FAILED open or read\n", files[i].name);
+            unreadable++;
+        } else if (check) {
+            if (memcmp(files[i].hash, files[i].expected, 8)) failed++;
+            printf("%s: %s\n", files[i].name, memcmp(files[i].hash, files[i].expected, 8) ? "FAILED" : "OK");
+        } else {
+            printf("%02x%02x%02x%02x%02x%02x%02x%02x  %s\n", files[i].hash[0], files[i].hash[1],
+                files[i].hash[2], files[i].hash[3], files[i].hash[4], files[i].hash[5],
+                files[i].hash[6], files[i].hash[7], files[i].name);
+        }
+    }
+    
+    fflush(stdout);
+    
+    if (malformed) {
+        fprintf(stderr, "%s: WARNING: %ld line%s improperly formatted\n", program, malformed,
+            malformed == 1 ? " is" : "s are");
+    }
+    if (check && unreadable) {
+        fprintf(stderr, "%s: WARNING: %ld listed file%s could not be read\n", program, unreadable,
+            unreadable == 1 ? "" : "s");
+    }
+    if (failed) {
+        fprintf(stderr, "%s: WARNING: %ld computed checksum%s did NOT match\n", program, failed,
+            failed == 1 ? "" : "s");
+    }
+    
+    if (check) {
+        for (i = 0; i < count; i++) free(files[i].name);
+        if (!count && !status) {
+            fprintf(stderr, "%s: no properly formatted checksum lines found\n", program);
+            status = 1;
+        }
+    }
+    free(files);
+    
+    return status || failed || unreadable ? 1 : 0;
+    
+}
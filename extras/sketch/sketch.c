@@ -0,0 +1,333 @@
+/*
+ * sketch.c
+ * Keyed Bloom filter and count-min sketch based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * The k probes of an item are derived from its single 64-bit SipHash by double hashing (Kirsch and
+ * Mitzenmacher): the upper half of the hash selects the cache line, and the i-th probe within it is
+ * a + i * b, where a and b are taken from the lower half, b being odd so the probes are distinct.
+ * Within the 512 bits of a Bloom filter block the progressions of different items overlap too
+ * often, so the filter adds the enhanced double hashing term (i^3 - i) / 6 (Dillinger and
+ * Manolios), which halves its false positive rate.
+ * 
+ * This implementation utilizes dynamically allocated buffers.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include "sketch.h"
+#include "siphash_batch.h"
+
+#define _MSH_BLOCK_BITS (MSH_SKETCH_LINE * 8)
+#define _MSH_LINE_WORDS (MSH_SKETCH_LINE / 4)
+
+#if defined(__GNUC__)
+#define _MSH_PREFETCH(p,rw) __builtin_prefetch(p, rw)
+#else
+#define _MSH_PREFETCH(p,rw) ((void) 0)
+#endif
+
+/*
+ * Decoded hash of an item, the line and the double hashing parameters.
+ */
+typedef struct {
+    size_t line;
+    uint32_t a, b;
+} _msh_probe;
+
+int msh_sketch_urandom(uint8_t *buf, const size_t len) {
+    
+    FILE *f = fopen("/dev/urandom", "rb");
+    size_t got;
+    
+    if (!f) return -1;
+    got = fread(buf, 1, len, f);
+    fclose(f);
+    
+    return got == len ? 0 : -1;
+    
+}
+
+static void _msh_decode(_msh_probe *probe, const uint8_t *hash, const size_t mask) {
+    
+    uint32_t lo = (uint32_t) hash[0] | ((uint32_t) hash[1] << 8) | ((uint32_t) hash[2] << 16) |
+        ((uint32_t) hash[3] << 24);
+    uint32_t hi = (uint32_t) hash[4] | ((uint32_t) hash[5] << 8) | ((uint32_t) hash[6] << 16) |
+        ((uint32_t) hash[7] << 24);
+    
+    probe->line = (size_t) hi & mask;
+    probe->a = lo & 0xffff;
+    probe->b = (lo >> 16) | 1;
+    
+}
+
+/*
+ * Allocate lines cache lines aligned to their size, plus the key. Returns the same as the init
+ * functions.
+ */
+static int _msh_sketch_alloc(void **mem, uint32_t **lines, const size_t count, uint8_t *raw_key,
+    siphash_key_t *key, msh_sketch_random_fn random) {
+    
+    if (!random) random = msh_sketch_urandom;
+    if (random(raw_key, 16)) return -1;
+    siphash_key_init(key, raw_key);
+    
+    *mem = calloc(count * MSH_SKETCH_LINE + MSH_SKETCH_LINE - 1, 1);
+    if (!*mem) return -2;
+    *lines = (uint32_t *) (((uintptr_t) *mem + MSH_SKETCH_LINE - 1) &
+        ~(uintptr_t) (MSH_SKETCH_LINE - 1));
+    
+    return 0;
+    
+}
+
+/*
+ * Bloom filter
+ */
+
+int msh_bloom_init(msh_bloom *bloom, const size_t items, const unsigned int bits_per_item,
+    msh_sketch_random_fn random) {
+    
+    size_t blocks = 1, needed = (items * bits_per_item + _MSH_BLOCK_BITS - 1) / _MSH_BLOCK_BITS;
+    
+    while (blocks < needed) blocks *= 2;
+    
+    /* The optimal number of probes for the bits per item after rounding. */
+    bloom->k = items ? (unsigned int) ((blocks * _MSH_BLOCK_BITS / items * 693 + 500) / 1000) : 16;
+    if (bloom->k < 1) bloom->k = 1;
+    if (bloom->k > 16) bloom->k = 16;
+    bloom->block_mask = blocks - 1;
+    
+    return _msh_sketch_alloc(&bloom->mem, &bloom->blocks, blocks, bloom->raw_key, &bloom->key,
+        random);
+    
+}
+
+void msh_bloom_free(msh_bloom *bloom) {
+    free(bloom->mem);
+    bloom->mem = NULL;
+    bloom->blocks = NULL;
+}
+
+static void _msh_bloom_set(msh_bloom *bloom, const _msh_probe *probe) {
+    
+    uint32_t *block = bloom->blocks + probe->line * _MSH_LINE_WORDS, bit = probe->a, step = probe->b;
+    unsigned int i;
+    
+    for (i = 0; i < bloom->k; i++) {
+        bit &= _MSH_BLOCK_BITS - 1;
+        block[bit >> 5] |= (uint32_t) 1 << (bit & 31);
+        bit += step;
+        step += i + 1;
+    }
+    
+}
+
+static int _msh_bloom_test(const msh_bloom *bloom, const _msh_probe *probe) {
+    
+    const uint32_t *block = bloom->blocks + probe->line * _MSH_LINE_WORDS;
+    uint32_t bit = probe->a, step = probe->b;
+    unsigned int i;
+    
+    for (i = 0; i < bloom->k; i++) {
+        bit &= _MSH_BLOCK_BITS - 1;
+        if (!(block[bit >> 5] & ((uint32_t) 1 << (bit & 31)))) return 0;
+        bit += step;
+        step += i + 1;
+    }
+    
+    return 1;
+    
+}
+
+void msh_bloom_add(msh_bloom *bloom, const uint8_t *item, const size_t len) {
+    
+    uint8_t hash[8];
+    _msh_probe probe;
+    
+    siphash_with_key(hash, item, len, &bloom->key);
+    _msh_decode(&probe, hash, bloom->block_mask);
+    _msh_bloom_set(bloom, &probe);
+    
+}
+
+int msh_bloom_query(const msh_bloom *bloom, const uint8_t *item, const size_t len) {
+    
+    uint8_t hash[8];
+    _msh_probe probe;
+    
+    siphash_with_key(hash, item, len, &bloom->key);
+    _msh_decode(&probe, hash, bloom->block_mask);
+    
+    return _msh_bloom_test(bloom, &probe);
+    
+}
+
+/*
+ * Hash a chunk of items and prefetch their lines, for writing if rw is 1.
+ */
+#define _MSH_SKETCH_CHUNK(s,lines,mask,rw) {                                \
+    cnt = n - i < MSH_SKETCH_CHUNK ? n - i : MSH_SKETCH_CHUNK;              \
+    siphash_batch(hashes, items + i, lens + i, cnt, (s)->raw_key);          \
+    for (j = 0; j < cnt; j++) {                                             \
+        _msh_decode(&probes[j], hashes + 8 * j, mask);                      \
+        _MSH_PREFETCH((lines) + probes[j].line * _MSH_LINE_WORDS, rw);      \
+    }                                                                       \
+}
+
+void msh_bloom_add_batch(msh_bloom *bloom, const uint8_t *const *items, const size_t *lens,
+    const size_t n) {
+    
+    uint8_t hashes[8 * MSH_SKETCH_CHUNK];
+    _msh_probe probes[MSH_SKETCH_CHUNK];
+    size_t i, j, cnt;
+    
+    for (i = 0; i < n; i += cnt) {
+        _MSH_SKETCH_CHUNK(bloom, bloom->blocks, bloom->block_mask, 1);
+        for (j = 0; j < cnt; j++) _msh_bloom_set(bloom, &probes[j]);
+    }
+    
+}
+
+void msh_bloom_query_batch(const msh_bloom *bloom, const uint8_t *const *items, const size_t *lens,
+    const size_t n, uint8_t *results) {
+    
+    uint8_t hashes[8 * MSH_SKETCH_CHUNK];
+    _msh_probe probes[MSH_SKETCH_CHUNK];
+    size_t i, j, cnt;
+    
+    for (i = 0; i < n; i += cnt) {
+        _MSH_SKETCH_CHUNK(bloom, bloom->blocks, bloom->block_mask, 0);
+        for (j = 0; j < cnt; j++) results[i + j] = (uint8_t) _msh_bloom_test(bloom, &probes[j]);
+    }
+    
+}
+
+/*
+ * Count-min sketch
+ */
+
+int msh_cms_init(msh_cms *cms, const size_t counters, const unsigned int depth,
+    msh_sketch_random_fn random) {
+    
+    size_t lines = 1, needed = (counters + _MSH_LINE_WORDS - 1) / _MSH_LINE_WORDS;
+    
+    while (lines < needed) lines *= 2;
+    
+    cms->depth = depth < 1 ? 1 : depth > _MSH_LINE_WORDS ? _MSH_LINE_WORDS : depth;
+    cms->line_mask = lines - 1;
+    
+    return _msh_sketch_alloc(&cms->mem, &cms->lines, lines, cms->raw_key, &cms->key, random);
+    
+}
+
+void msh_cms_free(msh_cms *cms) {
+    free(cms->mem);
+    cms->mem = NULL;
+    cms->lines = NULL;
+}
+
+static uint32_t _msh_cms_min(const msh_cms *cms, const _msh_probe *probe) {
+    
+    const uint32_t *line = cms->lines + probe->line * _MSH_LINE_WORDS;
+    uint32_t idx = probe->a, min = 0xffffffffUL;
+    unsigned int i;
+    
+    for (i = 0; i < cms->depth; i++) {
+        idx &= _MSH_LINE_WORDS - 1;
+        if (line[idx] < min) min = line[idx];
+        idx += probe->b;
+    }
+    
+    return min;
+    
+}
+
+static void _msh_cms_raise(msh_cms *cms, const _msh_probe *probe, const uint32_t count) {
+    
+    uint32_t *line = cms->lines + probe->line * _MSH_LINE_WORDS;
+    uint32_t idx = probe->a, target = _msh_cms_min(cms, probe);
+    unsigned int i;
+    
+    /* Saturate rather than wrap around. */
+    target = target + count < target ? 0xffffffffUL : target + count;
+    
+    for (i = 0; i < cms->depth; i++) {
+        idx &= _MSH_LINE_WORDS - 1;
+        if (line[idx] < target) line[idx] = target;
+        idx += probe->b;
+    }
+    
+}
+
+void msh_cms_add(msh_cms *cms, const uint8_t *item, const size_t len, const uint32_t count) {
+    
+    uint8_t hash[8];
+    _msh_probe probe;
+    
+    siphash_with_key(hash, item, len, &cms->key);
+    _msh_decode(&probe, hash, cms->line_mask);
+    _msh_cms_raise(cms, &probe, count);
+    
+}
+
+uint32_t msh_cms_estimate(const msh_cms *cms, const uint8_t *item, const size_t len) {
+    
+    uint8_t hash[8];
+    _msh_probe probe;
+    
+    siphash_with_key(hash, item, len, &cms->key);
+    _msh_decode(&probe, hash, cms->line_mask);
+    
+    return _msh_cms_min(cms, &probe);
+    
+}
+
+void msh_cms_add_batch(msh_cms *cms, const uint8_t *const *items, const size_t *lens,
+    const uint32_t *counts, const size_t n) {
+    
+    uint8_t hashes[8 * MSH_SKETCH_CHUNK];
+    _msh_probe probes[MSH_SKETCH_CHUNK];
+    size_t i, j, cnt;
+    
+    for (i = 0; i < n; i += cnt) {
+        _MSH_SKETCH_CHUNK(cms, cms->lines, cms->line_mask, 1);
+        for (j = 0; j < cnt; j++) _msh_cms_raise(cms, &probes[j], counts ? counts[i + j] : 1);
+    }
+    
+}
+
+void msh_cms_estimate_batch(const msh_cms *cms, const uint8_t *const *items, const size_t *lens,
+    const size_t n, uint32_t *estimates) {
+    
+    uint8_t hashes[8 * MSH_SKETCH_CHUNK];
+    _msh_probe probes[MSH_SKETCH_CHUNK];
+    size_t i, j, cnt;
+    
+    for (i = 0; i < n; i += cnt) {
+        _MSH_SKETCH_CHUNK(cms, cms->lines, cms->line_mask, 0);
+        for (j = 0; j < cnt; j++) estimates[i + j] = _msh_cms_min(cms, &probes[j]);
+    }
+    
+}
@@ -0,0 +1,145 @@
+/*
+ * sketch.h
+ * Keyed Bloom filter and count-min sketch based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ *
+ * Items are hashed with SipHash under a random per-structure key, so an attacker who doesn't know
+ * it can't craft items saturating the filter or inflating the counts of others. All the probes of
+ * an item are derived from a single hash and fall into a single cache line.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+#ifndef _SKETCH_SIPHASH_H
+#define _SKETCH_SIPHASH_H
+
+#include "siphash.h"
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Size of the blocks, one cache line. */
+#define MSH_SKETCH_LINE 64
+
+/* Number of items hashed at once by the batch entry points before their lines are touched. */
+#ifndef MSH_SKETCH_CHUNK
+#define MSH_SKETCH_CHUNK 32
+#endif
+
+/*
+ * Source of random keys. Shall fill len bytes under buf and return 0, or non-zero on failure.
+ */
+typedef int (*msh_sketch_random_fn)(uint8_t *buf, const size_t len);
+
+/*
+ * Blocked Bloom filter. Each block is a cache line of 512 bits, all k bits of an item are set in
+ * the block selected by its hash.
+ */
+typedef struct {
+    uint32_t *blocks;
+    void *mem;
+    size_t block_mask;
+    unsigned int k;
+    uint8_t raw_key[16];
+    siphash_key_t key;
+} msh_bloom;
+
+/*
+ * Count-min sketch of depth counters per item, all of them in the line of 16 counters selected by
+ * its hash. Counters saturate instead of wrapping around.
+ */
+typedef struct {
+    uint32_t *lines;
+    void *mem;
+    size_t line_mask;
+    unsigned int depth;
+    uint8_t raw_key[16];
+    siphash_key_t key;
+} msh_cms;
+
+/*
+ * Reads the random key from /dev/urandom.
+ */
+int msh_sketch_urandom(uint8_t *buf, const size_t len);
+
+/*
+ * Initialize the filter for items entries with bits_per_item bits each, rounded up to a power of
+ * two number of blocks. The number of probes is the bits per item after rounding times ln 2, at
+ * most 16. If random is NULL, msh_sketch_urandom() is used. Returns 0 on success, -1 when the key
+ * can't be obtained and -2 when memory can't be allocated.
+ */
+int msh_bloom_init(msh_bloom *bloom, const size_t items, const unsigned int bits_per_item,
+    msh_sketch_random_fn random);
+void msh_bloom_free(msh_bloom *bloom);
+
+void msh_bloom_add(msh_bloom *bloom, const uint8_t *item, const size_t len);
+
+/*
+ * Returns 1 if the item may have been added, 0 if it certainly was not.
+ */
+int msh_bloom_query(const msh_bloom *bloom, const uint8_t *item, const size_t len);
+
+/*
+ * Add or query n items at once. The hashes of a chunk of items are computed by siphash_batch() and
+ * their lines are prefetched before any of them is touched. The result of the i-th query is
+ * stored under results[i].
+ */
+void msh_bloom_add_batch(msh_bloom *bloom, const uint8_t *const *items, const size_t *lens,
+    const size_t n);
+void msh_bloom_query_batch(const msh_bloom *bloom, const uint8_t *const *items, const size_t *lens,
+    const size_t n, uint8_t *results);
+
+/*
+ * Initialize the sketch of at least counters counters, rounded up to a power of two number of
+ * lines, and depth counters per item, at most 16. Returns the same as msh_bloom_init().
+ */
+int msh_cms_init(msh_cms *cms, const size_t counters, const unsigned int depth,
+    msh_sketch_random_fn random);
+void msh_cms_free(msh_cms *cms);
+
+/*
+ * Add count occurrences of the item. With the conservative update only the counters below the new
+ * estimate are raised, which never makes an estimate lower than the true count.
+ */
+void msh_cms_add(msh_cms *cms, const uint8_t *item, const size_t len, const uint32_t count);
+
+/*
+ * Returns the estimated number of occurrences of the item, never lower than the true one.
+ */
+uint32_t msh_cms_estimate(const msh_cms *cms, const uint8_t *item, const size_t len);
+
+/*
+ * Add or estimate n items at once, the same way as the Bloom filter batches. If counts is NULL,
+ * every item is added once.
+ */
+void msh_cms_add_batch(msh_cms *cms, const uint8_t *const *items, const size_t *lens,
+    const uint32_t *counts, const size_t n);
+void msh_cms_estimate_batch(const msh_cms *cms, const uint8_t *const *items, const size_t *lens,
+    const size_t n, uint32_t *estimates);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ * siphashstat.c
+ * Instrumentation dump based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Hashes every line of the inputs the way a hash table would hash its keys, and dumps the
+ * instrumentation counters of the run: the calls, bytes and rounds, and the length and latency
+ * histograms. Stands for a workload to profile when the application itself can't dump them.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <errno.h>
+#include "stats.h"
+#include "hex.h"
+
+static const char *program = "siphashstat";
+
+static void usage(void) {
+    fprintf(stderr, "Usage: %s [-k KEY] [-n N] [FILE]...\n"
+        "Hash every line of the FILEs with SipHash-2-4 and dump the instrumentation counters.\n"
+        "With no FILE, or when FILE is -, read the standard input.\n\n"
+        "  -k, --key KEY     hash key as 32 hex digits, zeros by default\n"
+        "  -n, --repeat N    hash every line N times\n", program);
+}
+
+int main(int argc, char **argv) {
+    
+    char *stdin_name = "-", *line = NULL;
+    const char *key_hex = NULL;
+    uint8_t key[16], hash[8];
+    siphash_key_t prepared;
+    siphash_stats stats;
+    size_t size = 0;
+    ssize_t len;
+    long repeat = 1, i;
+    int status = 0, arg;
+    FILE *in;
+    
+    for (arg = 1; arg < argc; arg++) {
+        if (!strcmp(argv[arg], "-k") || !strcmp(argv[arg], "--key")) {
+            if (++arg == argc) break;
+            key_hex = argv[arg];
+        } else if (!strcmp(argv[arg], "-n") || !strcmp(argv[arg], "--repeat")) {
+            if (++arg == argc) break;
+            repeat = atol(argv[arg]);
+        } else if (!strcmp(argv[arg], "-h") || !strcmp(argv[arg], "--help")) {
+            usage();
+            return 0;
+        } else if (!strcmp(argv[arg], "--")) {
+            arg++;
+            break;
+        } else if (argv[arg][0] == '-' && argv[arg][1]) {
+            usage();
+            return 2;
+        } else {
+            break;
+        }
+    }
+    
+    memset(key, 0, sizeof(key));
+    if ((key_hex && (strlen(key_hex) != 32 || msh_hex_decode(key, key_hex, 16))) || repeat < 1) {
+        usage();
+        return 2;
+    }
+    
+    if (arg == argc) {
+        argv = &stdin_name;
+        argc = 1;
+        arg = 0;
+    }
+    
+    siphash_key_init(&prepared, key);
+    siphash_stats_reset();
+    
+    for (; arg < argc; arg++) {
+        in = strcmp(argv[arg], "-") ? fopen(argv[arg], "r") : stdin;
+        if (!in) {
+            fprintf(stderr, "%s: %s: %s\n", program, argv[arg], strerror(errno));
+            status = 1;
+            continue;
+        }
+        while ((len = getline(&line, &size, in)) >= 0) {
+            if (len && line[len - 1] == '\n') len--;
+            for (i = 0; i < repeat; i++) {
+                siphash_with_key(hash, (const uint8_t *) line, (size_t) len, &prepared);
+            }
+        }
+        if (in != stdin) fclose(in);
+    }
+    
+    siphash_stats_snapshot(&stats);
+    siphash_stats_dump(stdout, &stats);
+    free(line);
+    
+    return status;
+    
+}
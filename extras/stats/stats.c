@@ -0,0 +1,90 @@
+/*
+ * stats.c
+ * Instrumentation dump based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include "stats.h"
+
+/* Width of the longest histogram bar. */
+#define STATS_BAR 40
+
+static double per(const double n, const unsigned long d) {
+    return d ? n / d : 0.0;
+}
+
+static void dump_histogram(FILE *out, const char *title, const unsigned long *buckets) {
+    
+    unsigned long most = 0, lo;
+    int i, j, first = -1, last = -1, bar;
+    char range[48];
+    
+    for (i = 0; i < SIPHASH_STATS_BUCKETS; i++) {
+        if (!buckets[i]) continue;
+        if (first < 0) first = i;
+        last = i;
+        if (buckets[i] > most) most = buckets[i];
+    }
+    
+    fprintf(out, "\n%-24s %12s\n", title, "hashes");
+    
+    for (i = first; i >= 0 && i <= last; i++) {
+        lo = i ? 1UL << (i - 1) : 0;
+        if (i == 0) sprintf(range, "0");
+        else if (i == SIPHASH_STATS_BUCKETS - 1) sprintf(range, "%lu+", lo);
+        else if (i == 1) sprintf(range, "1");
+        else sprintf(range, "%lu-%lu", lo, 2 * lo - 1);
+        bar = (int) (buckets[i] * (double) STATS_BAR / most + 0.5);
+        if (buckets[i] && !bar) bar = 1;
+        fprintf(out, "  %-22s %12lu  ", range, buckets[i]);
+        for (j = 0; j < bar; j++) fputc('#', out);
+        fputc('\n', out);
+    }
+    
+}
+
+void siphash_stats_dump(FILE *out, const siphash_stats *stats) {
+    
+    unsigned long hashes = stats->calls - stats->streams;
+    
+    fprintf(out, "%-24s %12lu (%lu streamed)\n", "calls", stats->calls, stats->streams);
+    fprintf(out, "%-24s %12lu (%.1f per call)\n", "bytes", stats->bytes,
+        per(stats->bytes, stats->calls));
+    fprintf(out, "%-24s %12lu (%.1f per call, %.3f per byte)\n", "compression rounds",
+        stats->compress_rounds, per(stats->compress_rounds, stats->calls),
+        per(stats->compress_rounds, stats->bytes));
+    fprintf(out, "%-24s %12lu (%.1f per call)\n", "finalization rounds", stats->final_rounds,
+        per(stats->final_rounds, stats->calls));
+    if (stats->cycles) {
+        /* No %llu in C89, the total is exact in a double up to 2^53 cycles. */
+        fprintf(out, "%-24s %12.0f (%.1f per hash, %.2f per byte)\n", "cycles",
+            (double) stats->cycles, per((double) stats->cycles, hashes),
+            per((double) stats->cycles, stats->bytes));
+    }
+    
+    if (hashes) dump_histogram(out, "length (bytes)", stats->length);
+    if (stats->cycles) dump_histogram(out, "latency (cycles)", stats->latency);
+    
+}
@@ -0,0 +1,138 @@
+/*
+ * siphash_tree.c
+ * Keyed tree hashing based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Leaves are hashed a batch at a time into a fixed tag buffer, which is then absorbed into the
+ * root, so the memory use doesn't depend on the input size.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include "siphash_tree.h"
+
+/* Leaves hashed between two updates of the root. */
+#define _MSH_TREE_BATCH 1024
+
+/* Leaves per task of the thread pool. */
+#define _MSH_TREE_TASK 16
+
+/* Domain separation label of the derived keys, e.g. "siphash-tree v1 leaf". */
+#define _MSH_TREE_STR_(x) #x
+#define _MSH_TREE_STR(x) _MSH_TREE_STR_(x)
+#define _MSH_TREE_LABEL(role) "siphash-tree v" _MSH_TREE_STR(SIPHASH_TREE_VERSION) " " role
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t leaf_size;
+    /* Index of the first leaf of the batch. */
+    uint64_t first;
+    size_t leaves;
+    siphash_key_t leaf_key;
+    uint8_t tags[8 * _MSH_TREE_BATCH];
+} _msh_tree_job;
+
+static void _msh_tree_le64(uint8_t *p, uint64_t v) {
+    int i;
+    for (i = 0; i < 8; i++, v >>= 8) p[i] = (uint8_t) v;
+}
+
+/*
+ * Derives a domain-separated key as the SipHash-2-4-128 of the label.
+ */
+static void _msh_tree_key(siphash_key_t *prepared, const uint8_t *key, const char *label) {
+    uint8_t derived[16];
+    siphash128(derived, (const uint8_t *) label, strlen(label), key);
+    siphash_key_init(prepared, derived);
+}
+
+/*
+ * Tags the leaves of a single task, T_i = SipHash-2-4(K_leaf, LE64(i) || leaf_i).
+ */
+static void _msh_tree_leaves(void *arg, size_t task) {
+    
+    _msh_tree_job *job = (_msh_tree_job *) arg;
+    uint8_t index[8];
+    siphash_ctx ctx;
+    size_t j, last, offset, n;
+    uint64_t i;
+    
+    j = task * _MSH_TREE_TASK;
+    last = j + _MSH_TREE_TASK < job->leaves ? j + _MSH_TREE_TASK : job->leaves;
+    
+    for (; j < last; j++) {
+        i = job->first + j;
+        offset = (size_t) i * job->leaf_size;
+        n = job->len - offset < job->leaf_size ? job->len - offset : job->leaf_size;
+        _msh_tree_le64(index, i);
+        siphash_init_with_key(&ctx, &job->leaf_key);
+        siphash_update(&ctx, index, 8);
+        siphash_update(&ctx, job->data + offset, n);
+        siphash_final(&ctx, job->tags + 8 * j);
+    }
+    
+}
+
+int siphash_tree(uint8_t *hash, const uint8_t *data, const size_t len, const size_t leaf_size,
+    const uint8_t *key, msh_pool *pool) {
+    
+    _msh_tree_job batch, *job = &batch;
+    siphash_key_t root_key;
+    siphash_ctx root;
+    uint8_t header[16];
+    size_t leaves, tasks, t;
+    uint64_t total;
+    
+    if (!leaf_size) return -1;
+    
+    _msh_tree_key(&job->leaf_key, key, _MSH_TREE_LABEL("leaf"));
+    _msh_tree_key(&root_key, key, _MSH_TREE_LABEL("root"));
+    
+    /* An empty input still has a single, empty leaf. */
+    total = len ? (len - 1) / leaf_size + 1 : 1;
+    
+    job->data = data;
+    job->len = len;
+    job->leaf_size = leaf_size;
+    
+    /* The root binds the input and the leaf sizes, LE64(len) || LE64(leaf_size) || T_0 || ... */
+    siphash_init_with_key(&root, &root_key);
+    _msh_tree_le64(header, len);
+    _msh_tree_le64(header + 8, leaf_size);
+    siphash_update(&root, header, 16);
+    
+    for (job->first = 0; job->first < total; job->first += leaves) {
+        leaves = total - job->first < _MSH_TREE_BATCH ? (size_t) (total - job->first) : _MSH_TREE_BATCH;
+        job->leaves = leaves;
+        tasks = (leaves + _MSH_TREE_TASK - 1) / _MSH_TREE_TASK;
+        if (pool) msh_pool_run(pool, _msh_tree_leaves, job, tasks);
+        else for (t = 0; t < tasks; t++) _msh_tree_leaves(job, t);
+        siphash_update(&root, job->tags, 8 * leaves);
+    }
+    
+    siphash_final(&root, hash);
+    
+    return 0;
+    
+}
@@ -0,0 +1,60 @@
+/*
+ * siphash_tree.h
+ * Keyed tree hashing based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ *
+ * A separately defined hash mode, which splits the input into fixed-size leaves hashed in
+ * parallel. Its results differ from siphash() of the same input; the construction is specified
+ * in README.md.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+#ifndef _TREE_SIPHASH_H
+#define _TREE_SIPHASH_H
+
+#include "siphash.h"
+#include "pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Version of the construction, a change of the version changes the results. */
+#define SIPHASH_TREE_VERSION 1
+
+/* Recommended leaf size. */
+#define SIPHASH_TREE_LEAF ((size_t) 1 << 16)
+
+/*
+ * Compute the 8 byte tree hash of data under the 16 byte key, with leaves of leaf_size bytes. The
+ * leaves are hashed on the threads of the pool, or serially if the pool is NULL. Returns -1 if the
+ * leaf size is 0.
+ */
+int siphash_tree(uint8_t *hash, const uint8_t *data, const size_t len, const size_t leaf_size,
+    const uint8_t *key, msh_pool *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
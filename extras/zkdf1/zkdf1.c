@@ -0,0 +1,221 @@
+/*
+ * zkdf1.c
+ * Zero-allocation semi-KDF1 based on mcu-csiphash-2-4 SipHash implementation
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * The i-th block of the derived key is SipHash-2-4 of BE32(i) || info. The blocks are independent,
+ * so on the 64-bit backend a few of them are computed at once, their rounds interleaved to hide the
+ * latency of the dependency chain within a single SipHash state.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include "zkdf1.h"
+
+#define _MSH_ZKDF_MAX_BLOCKS 0xffffffffUL
+
+#if MSH_BACKEND == MSH_BACKEND_64BIT
+
+#define _MSH_ZKDF_LANES 4
+
+#define _MSH_ZKDF_ROTL(v,b) (((v) << (b)) | ((v) >> (64 - (b))))
+
+#define _MSH_ZKDF_ROUND(v0,v1,v2,v3) {                      \
+    v0 += v1;                                               \
+    v2 += v3;                                               \
+    v1 = _MSH_ZKDF_ROTL(v1, 13);                            \
+    v3 = _MSH_ZKDF_ROTL(v3, 16);                            \
+    v1 ^= v0;                                               \
+    v3 ^= v2;                                               \
+    v0 = _MSH_ZKDF_ROTL(v0, 32);                            \
+    v2 += v1;                                               \
+    v0 += v3;                                               \
+    v1 = _MSH_ZKDF_ROTL(v1, 17);                            \
+    v3 = _MSH_ZKDF_ROTL(v3, 21);                            \
+    v1 ^= v2;                                               \
+    v3 ^= v0;                                               \
+    v2 = _MSH_ZKDF_ROTL(v2, 32);                            \
+}
+
+/*
+ * The lanes are held in separate variables rather than arrays so that they stay in registers. Their
+ * states are independent, so the compiler is free to interleave their instructions.
+ */
+#define _MSH_ZKDF_ROUNDS(n) {                               \
+    for (r = 0; r < (n); r++) {                             \
+        _MSH_ZKDF_ROUND(a0, a1, a2, a3);                    \
+        _MSH_ZKDF_ROUND(b0, b1, b2, b3);                    \
+        _MSH_ZKDF_ROUND(c0, c1, c2, c3);                    \
+        _MSH_ZKDF_ROUND(d0, d1, d2, d3);                    \
+    }                                                       \
+}
+
+#define _MSH_ZKDF_INIT(v0,v1,v2,v3) {                       \
+    v0 = k0 ^ UINT64_C(0x736f6d6570736575);                 \
+    v1 = k1 ^ UINT64_C(0x646f72616e646f6d);                 \
+    v2 = k0 ^ UINT64_C(0x6c7967656e657261);                 \
+    v3 = k1 ^ UINT64_C(0x7465646279746573);                 \
+}
+
+#define _MSH_ZKDF_STORE(p,v0,v1,v2,v3) {                    \
+    m = v0 ^ v1 ^ v2 ^ v3;                                  \
+    for (r = 0; r < 8; r++) (p)[r] = (uint8_t) (m >> (r << 3)); \
+}
+
+/* Counter i as big-endian bytes in the least significant half of a little-endian word. */
+#define _MSH_ZKDF_COUNTER(i) (                              \
+    (((uint64_t) (i) >> 24) & 0xff) |                       \
+    (((uint64_t) (i) >> 8) & 0xff00) |                      \
+    (((uint64_t) (i) << 8) & 0xff0000) |                    \
+    (((uint64_t) (i) << 24) & 0xff000000UL))
+
+static uint64_t _msh_zkdf_load(const uint8_t *p) {
+    return ((uint64_t) p[0])       | ((uint64_t) p[1] << 8)  |
+           ((uint64_t) p[2] << 16) | ((uint64_t) p[3] << 24) |
+           ((uint64_t) p[4] << 32) | ((uint64_t) p[5] << 40) |
+           ((uint64_t) p[6] << 48) | ((uint64_t) p[7] << 56);
+}
+
+/*
+ * The w-th message word of 0^32 || info, including the length byte if it is the last one. The
+ * counter is xored into the first word by the caller.
+ */
+static uint64_t _msh_zkdf_word(const uint8_t *info, const size_t info_len, const size_t w) {
+    
+    size_t total = info_len + 4, pos = 8 * w, i;
+    uint64_t m = 0;
+    
+    if (pos >= 4 && pos + 8 <= total) return _msh_zkdf_load(info + pos - 4);
+    
+    for (i = 0; i < 8; i++, pos++) {
+        if (pos >= 4 && pos < total) m |= (uint64_t) info[pos - 4] << (i << 3);
+    }
+    
+    if (8 * w + 8 > total) m |= (uint64_t) (total & 0xff) << 56;
+    
+    return m;
+    
+}
+
+int zkdf1(uint8_t *derived_key, const size_t derived_key_length,
+    const uint8_t *info, const size_t info_len,
+    const uint8_t *hash_key) {
+    
+    uint64_t a0, a1, a2, a3, b0, b1, b2, b3, c0, c1, c2, c3, d0, d1, d2, d3;
+    uint64_t k0, k1, m, ca, cb, cc, cd;
+    uint8_t hash[8 * _MSH_ZKDF_LANES];
+    size_t offset, words, w, n;
+    uint32_t counter = 0;
+    int r;
+    
+    if (!derived_key_length) return 0;
+    if ((derived_key_length - 1) / 8 > _MSH_ZKDF_MAX_BLOCKS) return -1;
+    
+    k0 = _msh_zkdf_load(hash_key);
+    k1 = _msh_zkdf_load(hash_key + 8);
+    words = (info_len + 4) / 8 + 1;
+    
+    for (offset = 0; offset < derived_key_length; offset += n) {
+        
+        _MSH_ZKDF_INIT(a0, a1, a2, a3);
+        _MSH_ZKDF_INIT(b0, b1, b2, b3);
+        _MSH_ZKDF_INIT(c0, c1, c2, c3);
+        _MSH_ZKDF_INIT(d0, d1, d2, d3);
+        
+        /* The counters only differ in the first word. */
+        m = _msh_zkdf_word(info, info_len, 0);
+        ca = m ^ _MSH_ZKDF_COUNTER(counter);
+        cb = m ^ _MSH_ZKDF_COUNTER((uint32_t) (counter + 1));
+        cc = m ^ _MSH_ZKDF_COUNTER((uint32_t) (counter + 2));
+        cd = m ^ _MSH_ZKDF_COUNTER((uint32_t) (counter + 3));
+        a3 ^= ca; b3 ^= cb; c3 ^= cc; d3 ^= cd;
+        _MSH_ZKDF_ROUNDS(2);
+        a0 ^= ca; b0 ^= cb; c0 ^= cc; d0 ^= cd;
+        
+        /* Every other word of the info is loaded once for all the lanes. */
+        for (w = 1; w < words; w++) {
+            m = _msh_zkdf_word(info, info_len, w);
+            a3 ^= m; b3 ^= m; c3 ^= m; d3 ^= m;
+            _MSH_ZKDF_ROUNDS(2);
+            a0 ^= m; b0 ^= m; c0 ^= m; d0 ^= m;
+        }
+        
+        a2 ^= 0xff; b2 ^= 0xff; c2 ^= 0xff; d2 ^= 0xff;
+        _MSH_ZKDF_ROUNDS(4);
+        
+        _MSH_ZKDF_STORE(hash, a0, a1, a2, a3);
+        _MSH_ZKDF_STORE(hash + 8, b0, b1, b2, b3);
+        _MSH_ZKDF_STORE(hash + 16, c0, c1, c2, c3);
+        _MSH_ZKDF_STORE(hash + 24, d0, d1, d2, d3);
+        
+        n = derived_key_length - offset;
+        if (n > sizeof(hash)) n = sizeof(hash);
+        memcpy(derived_key + offset, hash, n);
+        counter += _MSH_ZKDF_LANES;
+        
+    }
+    
+    return 0;
+    
+}
+
+#else
+
+int zkdf1(uint8_t *derived_key, const size_t derived_key_length,
+    const uint8_t *info, const size_t info_len,
+    const uint8_t *hash_key) {
+    
+    siphash_key_t prepared;
+    siphash_ctx ctx;
+    uint8_t hash[8], counter[4];
+    uint32_t i = 0;
+    size_t offset, n;
+    
+    if (!derived_key_length) return 0;
+    if ((derived_key_length - 1) / 8 > _MSH_ZKDF_MAX_BLOCKS) return -1;
+    
+    siphash_key_init(&prepared, hash_key);
+    
+    for (offset = 0; offset < derived_key_length; offset += n, i++) {
+        
+        counter[0] = (uint8_t) (i >> 24);
+        counter[1] = (uint8_t) (i >> 16);
+        counter[2] = (uint8_t) (i >> 8);
+        counter[3] = (uint8_t) i;
+        
+        siphash_init_with_key(&ctx, &prepared);
+        siphash_update(&ctx, counter, 4);
+        siphash_update(&ctx, info, info_len);
+        siphash_final(&ctx, hash);
+        
+        n = derived_key_length - offset;
+        if (n > 8) n = 8;
+        memcpy(derived_key + offset, hash, n);
+        
+    }
+    
+    return 0;
+    
+}
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * driver.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Standalone driver of the fuzz target. With file arguments it runs the target once per file,
+ * which is how AFL runs it and how crashes found by libFuzzer are reproduced. Otherwise it runs
+ * the target on random inputs:
+ * 
+ *      driver [-n ITERATIONS] [-s SEED] [FILE]...
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "siphash.h"
+
+#define MAXLEN 65536
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static uint32_t state;
+
+static uint32_t next(void) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static int run_file(const char *path) {
+    
+    static uint8_t buffer[MAXLEN + 20];
+    size_t size;
+    FILE *in;
+    
+    in = fopen(path, "rb");
+    if (!in) {
+        perror(path);
+        return 0;
+    }
+    size = fread(buffer, 1, sizeof(buffer), in);
+    fclose(in);
+    
+    LLVMFuzzerTestOneInput(buffer, size);
+    
+    return 1;
+    
+}
+
+int main(int argc, char **argv) {
+    
+    static uint8_t buffer[MAXLEN + 20];
+    unsigned long iterations = 2000, n;
+    size_t size, i;
+    int arg, files = 0;
+    
+    state = 1;
+    
+    for (arg = 1; arg < argc; arg++) {
+        if (!strcmp(argv[arg], "-n") && arg + 1 < argc) {
+            iterations = strtoul(argv[++arg], NULL, 10);
+        } else if (!strcmp(argv[arg], "-s") && arg + 1 < argc) {
+            state = (uint32_t) strtoul(argv[++arg], NULL, 10);
+            if (!state) state = 1;
+        } else {
+            if (!run_file(argv[arg])) return 1;
+            files++;
+        }
+    }
+    
+    if (files) {
+        printf("fuzz ok: %d files (%d-bit backend)\n", files, MSH_BACKEND);
+        return 0;
+    }
+    
+    for (n = 0; n < iterations; n++) {
+        
+        /*
+         * Mostly messages up to 1 KiB, which cover the length byte wrapping at 256 several times,
+         * and every 8th one up to 64 KiB.
+         */
+        size = 20 + (n % 8 ? next() % 1025 : next() % (MAXLEN + 1));
+        
+        /* Keys of all zero and all one bits now and then. */
+        for (i = 0; i < size; i++) buffer[i] = (uint8_t) next();
+        if (n % 64 == 1) memset(buffer, 0x00, 16);
+        if (n % 64 == 2) memset(buffer, 0xff, 16);
+        
+        LLVMFuzzerTestOneInput(buffer, size);
+        
+    }
+    
+    printf("fuzz ok: %lu random inputs (%d-bit backend)\n", iterations, MSH_BACKEND);
+    
+    return 0;
+    
+}
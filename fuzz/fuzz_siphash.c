@@ -0,0 +1,407 @@
+/*
+ * fuzz_siphash.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Differential fuzz target, comparing the public entry points of the core, the SIMD batch kernels
+ * and the zkdf1, kdf1_batch and batched MAC extras built on them against the reference on native
+ * words. The input is laid out as
+ * 
+ *      key (16 bytes) || split seed (4 bytes) || message
+ * 
+ * missing bytes of the key and the seed being zero. The seed drives the chunk lengths of the
+ * incremental interface, the split of the message across the batch lanes and the derived key
+ * lengths. The target aborts on the first mismatch.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "siphash.h"
+#include "halfsiphash.h"
+#include "zkdf1.h"
+#include "fkdf1.h"
+#include "siphash_batch.h"
+#include "mac.h"
+#include "reference.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+typedef void (*fuzz_fn)(uint8_t *, const uint8_t *, const size_t, const uint8_t *);
+typedef void (*fuzz_prepared_fn)(uint8_t *, const uint8_t *, const size_t, const siphash_key_t *);
+
+static const struct {
+    const char *name;
+    fuzz_fn fn;
+    fuzz_prepared_fn prepared;
+    int c, d, outlen;
+} functions[] = {
+    {"siphash", siphash, siphash_with_key, 2, 4, 8},
+    {"siphash24", siphash24, siphash24_with_key, 2, 4, 8},
+    {"siphash13", siphash13, siphash13_with_key, 1, 3, 8},
+    {"siphash48", siphash48, siphash48_with_key, 4, 8, 8},
+    {"siphash128", siphash128, siphash128_with_key, 2, 4, 16}
+};
+
+static void fuzz_fail(const char *name, const size_t len, const uint8_t *expected, const uint8_t *got,
+    const int outlen) {
+    
+    int i;
+    
+    printf("%s mismatch for %lu bytes\nExpected:\t", name, (unsigned long) len);
+    for (i = 0; i < outlen; i++) printf("0x%02x ", expected[i]);
+    printf("\nGot:\t\t");
+    for (i = 0; i < outlen; i++) printf("0x%02x ", got[i]);
+    printf("\n");
+    fflush(stdout);
+    
+    abort();
+    
+}
+
+/*
+ * The incremental interface, chunk lengths taken from a xorshift generator. Mostly short chunks,
+ * which exercise the partial word carried between the updates, with occasional long ones.
+ */
+static void fuzz_chunked(uint8_t *hash, const uint8_t *msg, const size_t len, const uint8_t *key,
+    uint32_t seed) {
+    
+    siphash_ctx ctx;
+    size_t offset = 0, chunk;
+    
+    if (!seed) seed = 1;
+    
+    siphash_init(&ctx, key);
+    
+    while (offset < len) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        chunk = seed & 0x100 ? seed % (len - offset + 1) : seed % 20;
+        if (chunk > len - offset) chunk = len - offset;
+        siphash_update(&ctx, msg + offset, chunk);
+        offset += chunk;
+    }
+    
+    siphash_final(&ctx, hash);
+    
+}
+
+#ifdef MSH_HAVE_IOVEC
+#define FUZZ_SEGMENTS 16
+
+/*
+ * The scatter-gather interface over the same kind of split, the remainder of the message going
+ * into the last segment once they run out.
+ */
+static void fuzz_segmented(uint8_t *hash, const uint8_t *msg, const size_t len, const uint8_t *key,
+    uint32_t seed) {
+    
+    struct iovec iov[FUZZ_SEGMENTS];
+    size_t offset = 0, chunk;
+    int n = 0;
+    
+    if (!seed) seed = 1;
+    
+    while (n < FUZZ_SEGMENTS - 1 && offset < len) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        chunk = seed & 0x100 ? seed % (len - offset + 1) : seed % 20;
+        if (chunk > len - offset) chunk = len - offset;
+        iov[n].iov_base = (void *) (msg + offset);
+        iov[n].iov_len = chunk;
+        offset += chunk;
+        n++;
+    }
+    
+    iov[n].iov_base = (void *) (msg + offset);
+    iov[n].iov_len = len - offset;
+    
+    siphash_v(hash, iov, n + 1, key);
+    
+}
+#endif
+
+/* Longest info and derived key checked against the reference derivation. */
+#define FUZZ_KDF_INFO 256
+#define FUZZ_KDF_LEN 300
+
+/*
+ * zkdf1() over the leading bytes of the message, block i being the hash of BE32(i) || info. The
+ * derived key length is taken from the seed.
+ */
+static void fuzz_zkdf1(const uint8_t *msg, const size_t len, const uint8_t *key, const uint32_t seed) {
+    
+    uint8_t buffer[4 + FUZZ_KDF_INFO], derived[FUZZ_KDF_LEN], expected[8];
+    size_t info_len = len < FUZZ_KDF_INFO ? len : FUZZ_KDF_INFO;
+    size_t derived_len = (seed >> 8) % (FUZZ_KDF_LEN + 1), offset, n;
+    uint32_t block;
+    
+    memcpy(buffer + 4, msg, info_len);
+    if (zkdf1(derived, derived_len, msg, info_len, key)) fuzz_fail("zkdf1", info_len, NULL, NULL, 0);
+    
+    for (offset = 0, block = 0; offset < derived_len; offset += 8, block++) {
+        buffer[0] = (uint8_t) (block >> 24);
+        buffer[1] = (uint8_t) (block >> 16);
+        buffer[2] = (uint8_t) (block >> 8);
+        buffer[3] = (uint8_t) block;
+        ref_siphash(expected, 8, 2, 4, buffer, 4 + info_len, key);
+        n = derived_len - offset < 8 ? derived_len - offset : 8;
+        if (memcmp(expected, derived + offset, n)) {
+            fuzz_fail("zkdf1", info_len, expected, derived + offset, (int) n);
+        }
+    }
+    
+}
+
+/* Messages of a batch, enough for several groups of the widest kernel and a partial one. */
+#define FUZZ_LANES 19
+
+static const char *fuzz_kernels[] = {"scalar", "sse2", "avx2", "avx512"};
+
+static void fuzz_batch_fail(const int isa, const char *name, const size_t len, const uint8_t *expected,
+    const uint8_t *got, const int outlen) {
+    printf("%s kernel: ", fuzz_kernels[isa]);
+    fuzz_fail(name, len, expected, got, outlen);
+}
+
+static uint32_t fuzz_next(uint32_t *seed) {
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+/*
+ * Splits the message into slices of mixed lengths, which may overlap: bare tails of 0-7 bytes, a
+ * few words with a tail, up to 63 bytes, or anything up to the rest of the message. Lanes of the
+ * same group thus finish at different words, with different tails. Returns the number of slices.
+ */
+static size_t fuzz_split(const uint8_t **datas, size_t *lens, const uint8_t *msg, const size_t len,
+    uint32_t seed) {
+    
+    size_t n, i, offset, want;
+    uint32_t r;
+    
+    if (!seed) seed = 1;
+    n = 1 + fuzz_next(&seed) % FUZZ_LANES;
+    
+    for (i = 0; i < n; i++) {
+        r = fuzz_next(&seed);
+        offset = r % (len + 1);
+        switch ((r >> 16) & 3) {
+            case 0: want = (r >> 18) % 8; break;
+            case 1: want = 8 * ((r >> 18) % 4) + (r >> 20) % 8; break;
+            case 2: want = (r >> 18) % 64; break;
+            default: want = (r >> 18) % (len - offset + 1); break;
+        }
+        datas[i] = msg + offset;
+        lens[i] = want < len - offset ? want : len - offset;
+    }
+    
+    return n;
+    
+}
+
+/*
+ * siphash_batch() and siphash_batch_keys() over the slices, checked lane by lane against the
+ * reference, followed by kdf1_batch() and the batched MAC, which run on top of them. The lane
+ * keys are the key with the lane index mixed into its first byte.
+ */
+static void fuzz_batch(const uint8_t *msg, const size_t len, const uint8_t *key, const uint32_t seed,
+    const int isa) {
+    
+    static uint8_t derived[FUZZ_LANES * FUZZ_KDF_LEN], scratch[KDF_BATCH_SCRATCH(FUZZ_LANES)];
+    static uint8_t packets[FUZZ_LANES][64 + SIPHASH_MAC_TAG];
+    uint8_t hashes[8 * FUZZ_LANES], lane_keys[FUZZ_LANES][16], expected[8], buffer[4 + KDF_INFO_LEN];
+    uint8_t bitmap[(FUZZ_LANES + 7) / 8];
+    const uint8_t *datas[FUZZ_LANES], *keys[FUZZ_LANES], *got;
+    siphash_mac_desc ring[FUZZ_LANES];
+    size_t lens[FUZZ_LANES], n, i, derived_len, offset, chunk;
+    uint32_t block;
+    
+    n = fuzz_split(datas, lens, msg, len, seed);
+    
+    for (i = 0; i < n; i++) {
+        memcpy(lane_keys[i], key, 16);
+        lane_keys[i][0] ^= (uint8_t) (i + 1);
+        keys[i] = lane_keys[i];
+    }
+    
+    siphash_batch(hashes, datas, lens, n, key);
+    for (i = 0; i < n; i++) {
+        ref_siphash(expected, 8, 2, 4, datas[i], lens[i], key);
+        if (memcmp(expected, hashes + 8 * i, 8)) {
+            fuzz_batch_fail(isa, "siphash_batch", lens[i], expected, hashes + 8 * i, 8);
+        }
+    }
+    
+    siphash_batch_keys(hashes, datas, lens, n, keys);
+    for (i = 0; i < n; i++) {
+        ref_siphash(expected, 8, 2, 4, datas[i], lens[i], keys[i]);
+        if (memcmp(expected, hashes + 8 * i, 8)) {
+            fuzz_batch_fail(isa, "siphash_batch_keys", lens[i], expected, hashes + 8 * i, 8);
+        }
+    }
+    
+    /* kdf1_batch() takes infos of up to KDF_INFO_LEN bytes, the slices are cut to fit. */
+    for (i = 0; i < n; i++) {
+        if (lens[i] > KDF_INFO_LEN) lens[i] = KDF_INFO_LEN;
+    }
+    derived_len = (seed >> 16) % (FUZZ_KDF_LEN + 1);
+    if (kdf1_batch(derived, derived_len, datas, lens, keys, n, scratch)) {
+        fuzz_batch_fail(isa, "kdf1_batch", derived_len, NULL, NULL, 0);
+    }
+    
+    for (i = 0; i < n; i++) {
+        memcpy(buffer + 4, datas[i], lens[i]);
+        for (offset = 0, block = 0; offset < derived_len; offset += 8, block++) {
+            buffer[0] = buffer[1] = buffer[2] = 0;
+            buffer[3] = (uint8_t) block;
+            ref_siphash(expected, 8, 2, 4, buffer, 4 + lens[i], keys[i]);
+            chunk = derived_len - offset < 8 ? derived_len - offset : 8;
+            got = derived + i * derived_len + offset;
+            if (memcmp(expected, got, chunk)) {
+                fuzz_batch_fail(isa, "kdf1_batch", lens[i], expected, got, (int) chunk);
+            }
+        }
+    }
+    
+    /* Packets of up to 64 bytes with trailing tags, the ring starting in its middle. */
+    for (i = 0; i < n; i++) {
+        chunk = lens[(i + 1) % n] + lens[i];
+        memcpy(packets[i], datas[i], lens[i]);
+        memcpy(packets[i] + lens[i], datas[(i + 1) % n], lens[(i + 1) % n]);
+        ring[i].data = packets[i];
+        ring[i].len = chunk;
+        ring[i].tag_off = chunk;
+    }
+    
+    siphash_mac_sign_batch(ring, n, n / 2, n, key);
+    for (i = 0; i < n; i++) {
+        ref_siphash(expected, 8, 2, 4, ring[i].data, ring[i].len, key);
+        got = ring[i].data + ring[i].tag_off;
+        if (memcmp(expected, got, 8)) {
+            fuzz_batch_fail(isa, "siphash_mac_sign_batch", ring[i].len, expected, got, 8);
+        }
+    }
+    
+    /* The tag of a single packet is broken, only its bit is cleared. */
+    chunk = seed % n;
+    ring[chunk].data[ring[chunk].tag_off + (seed >> 8) % 8] ^= (uint8_t) (1 << ((seed >> 11) % 8));
+    if (siphash_mac_verify_batch(ring, n, n / 2, n, key, bitmap) != n - 1) {
+        fuzz_batch_fail(isa, "siphash_mac_verify_batch", ring[chunk].len, NULL, NULL, 0);
+    }
+    for (i = 0; i < n; i++) {
+        if (!(bitmap[i / 8] >> (i % 8) & 1) != ((n / 2 + i) % n == chunk)) {
+            fuzz_batch_fail(isa, "siphash_mac_verify_batch", ring[i].len, NULL, NULL, 0);
+        }
+    }
+    
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    
+    uint8_t key[16], seed_bytes[4], expected[16], got[16];
+    const uint8_t *msg;
+    siphash_key_t prepared;
+    siphash_ctx ctx;
+    uint32_t seed;
+    size_t len, i;
+    int isa;
+    
+    memset(key, 0, sizeof(key));
+    memset(seed_bytes, 0, sizeof(seed_bytes));
+    memcpy(key, data, size < 16 ? size : 16);
+    if (size > 16) memcpy(seed_bytes, data + 16, size < 20 ? size - 16 : 4);
+    
+    msg = size > 20 ? data + 20 : data;
+    len = size > 20 ? size - 20 : 0;
+    seed = (uint32_t) seed_bytes[0] | (uint32_t) seed_bytes[1] << 8 | (uint32_t) seed_bytes[2] << 16 |
+        (uint32_t) seed_bytes[3] << 24;
+    
+    siphash_key_init(&prepared, key);
+    
+    for (i = 0; i < sizeof(functions) / sizeof(functions[0]); i++) {
+        ref_siphash(expected, functions[i].outlen, functions[i].c, functions[i].d, msg, len, key);
+        functions[i].fn(got, msg, len, key);
+        if (memcmp(expected, got, functions[i].outlen)) {
+            fuzz_fail(functions[i].name, len, expected, got, functions[i].outlen);
+        }
+        functions[i].prepared(got, msg, len, &prepared);
+        if (memcmp(expected, got, functions[i].outlen)) {
+            fuzz_fail(functions[i].name, len, expected, got, functions[i].outlen);
+        }
+    }
+    
+    /* Fixed length entry points over the leading bytes of the message. */
+    if (len >= 16) {
+        ref_siphash(expected, 8, 2, 4, msg, 4, key);
+        siphash_u32(got, msg, &prepared);
+        if (memcmp(expected, got, 8)) fuzz_fail("siphash_u32", 4, expected, got, 8);
+        ref_siphash(expected, 8, 2, 4, msg, 8, key);
+        siphash_u64(got, msg, &prepared);
+        if (memcmp(expected, got, 8)) fuzz_fail("siphash_u64", 8, expected, got, 8);
+        ref_siphash(expected, 8, 2, 4, msg, 16, key);
+        siphash_u128(got, msg, &prepared);
+        if (memcmp(expected, got, 8)) fuzz_fail("siphash_u128", 16, expected, got, 8);
+    }
+    
+    /* Incremental interface, in a single update and in random chunks. */
+    ref_siphash(expected, 8, 2, 4, msg, len, key);
+    
+    siphash_init_with_key(&ctx, &prepared);
+    siphash_update(&ctx, msg, len);
+    siphash_final(&ctx, got);
+    if (memcmp(expected, got, 8)) fuzz_fail("siphash_update", len, expected, got, 8);
+    
+    fuzz_chunked(got, msg, len, key, seed);
+    if (memcmp(expected, got, 8)) fuzz_fail("siphash_update chunked", len, expected, got, 8);
+    
+#ifdef MSH_HAVE_IOVEC
+    fuzz_segmented(got, msg, len, key, seed);
+    if (memcmp(expected, got, 8)) fuzz_fail("siphash_v", len, expected, got, 8);
+#endif
+    
+    fuzz_zkdf1(msg, len, key, seed);
+    
+    /* Every batch kernel the CPU supports, the scalar fallback included. */
+    for (isa = SIPHASH_BATCH_SCALAR; isa <= SIPHASH_BATCH_AVX512; isa++) {
+        if (siphash_batch_select(isa) == isa) fuzz_batch(msg, len, key, seed, isa);
+    }
+    siphash_batch_select(SIPHASH_BATCH_AUTO);
+    
+    /* HalfSipHash takes the first half of the key. */
+    ref_halfsiphash(expected, 4, msg, len, key);
+    halfsiphash(got, msg, len, key);
+    if (memcmp(expected, got, 4)) fuzz_fail("halfsiphash", len, expected, got, 4);
+    
+    ref_halfsiphash(expected, 8, msg, len, key);
+    halfsiphash64(got, msg, len, key);
+    if (memcmp(expected, got, 8)) fuzz_fail("halfsiphash64", len, expected, got, 8);
+    
+    return 0;
+    
+}
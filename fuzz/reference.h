@@ -0,0 +1,145 @@
+/*
+ * reference.h
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Straightforward SipHash-c-d and HalfSipHash-c-d on native words, following the paper rather than
+ * any of the backends, which the fuzzer compares the library against
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+#ifndef _FUZZ_REFERENCE_H
+#define _FUZZ_REFERENCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define REF_ROTL(x,b,bits) (((x) << (b)) | ((x) >> ((bits) - (b))))
+
+static void ref_round64(uint64_t *v) {
+    v[0] += v[1]; v[1] = REF_ROTL(v[1], 13, 64); v[1] ^= v[0]; v[0] = REF_ROTL(v[0], 32, 64);
+    v[2] += v[3]; v[3] = REF_ROTL(v[3], 16, 64); v[3] ^= v[2];
+    v[0] += v[3]; v[3] = REF_ROTL(v[3], 21, 64); v[3] ^= v[0];
+    v[2] += v[1]; v[1] = REF_ROTL(v[1], 17, 64); v[1] ^= v[2]; v[2] = REF_ROTL(v[2], 32, 64);
+}
+
+static void ref_round32(uint32_t *v) {
+    v[0] += v[1]; v[1] = REF_ROTL(v[1], 5, 32); v[1] ^= v[0]; v[0] = REF_ROTL(v[0], 16, 32);
+    v[2] += v[3]; v[3] = REF_ROTL(v[3], 8, 32); v[3] ^= v[2];
+    v[0] += v[3]; v[3] = REF_ROTL(v[3], 7, 32); v[3] ^= v[0];
+    v[2] += v[1]; v[1] = REF_ROTL(v[1], 13, 32); v[1] ^= v[2]; v[2] = REF_ROTL(v[2], 16, 32);
+}
+
+/*
+ * SipHash-c-d with 8 or 16 byte output.
+ */
+static void ref_siphash(uint8_t *out, const int outlen, const int c, const int d,
+    const uint8_t *in, const size_t len, const uint8_t *key) {
+    
+    uint64_t v[4], k0 = 0, k1 = 0, m, b;
+    size_t i;
+    int j, r, o;
+    
+    for (j = 0; j < 8; j++) {
+        k0 |= (uint64_t) key[j] << (8 * j);
+        k1 |= (uint64_t) key[8 + j] << (8 * j);
+    }
+    
+    v[0] = k0 ^ UINT64_C(0x736f6d6570736575);
+    v[1] = k1 ^ UINT64_C(0x646f72616e646f6d);
+    v[2] = k0 ^ UINT64_C(0x6c7967656e657261);
+    v[3] = k1 ^ UINT64_C(0x7465646279746573);
+    if (outlen == 16) v[1] ^= 0xee;
+    
+    for (i = 0; i + 8 <= len; i += 8) {
+        m = 0;
+        for (j = 0; j < 8; j++) m |= (uint64_t) in[i + j] << (8 * j);
+        v[3] ^= m;
+        for (r = 0; r < c; r++) ref_round64(v);
+        v[0] ^= m;
+    }
+    
+    b = (uint64_t) len << 56;
+    for (j = 0; i + j < len; j++) b |= (uint64_t) in[i + j] << (8 * j);
+    v[3] ^= b;
+    for (r = 0; r < c; r++) ref_round64(v);
+    v[0] ^= b;
+    
+    v[2] ^= outlen == 16 ? 0xee : 0xff;
+    
+    for (o = 0; o < outlen; o += 8) {
+        if (o) v[1] ^= 0xdd;
+        for (r = 0; r < d; r++) ref_round64(v);
+        b = v[0] ^ v[1] ^ v[2] ^ v[3];
+        for (j = 0; j < 8; j++) out[o + j] = (uint8_t) (b >> (8 * j));
+    }
+    
+}
+
+/*
+ * HalfSipHash-2-4 with 4 or 8 byte output.
+ */
+static void ref_halfsiphash(uint8_t *out, const int outlen, const uint8_t *in, const size_t len,
+    const uint8_t *key) {
+    
+    uint32_t v[4], k0 = 0, k1 = 0, m, b;
+    size_t i;
+    int j, r, o;
+    
+    for (j = 0; j < 4; j++) {
+        k0 |= (uint32_t) key[j] << (8 * j);
+        k1 |= (uint32_t) key[4 + j] << (8 * j);
+    }
+    
+    v[0] = k0;
+    v[1] = k1;
+    v[2] = k0 ^ 0x6c796765UL;
+    v[3] = k1 ^ 0x74656462UL;
+    if (outlen == 8) v[1] ^= 0xee;
+    
+    for (i = 0; i + 4 <= len; i += 4) {
+        m = 0;
+        for (j = 0; j < 4; j++) m |= (uint32_t) in[i + j] << (8 * j);
+        v[3] ^= m;
+        for (r = 0; r < 2; r++) ref_round32(v);
+        v[0] ^= m;
+    }
+    
+    b = (uint32_t) len << 24;
+    for (j = 0; i + j < len; j++) b |= (uint32_t) in[i + j] << (8 * j);
+    v[3] ^= b;
+    for (r = 0; r < 2; r++) ref_round32(v);
+    v[0] ^= b;
+    
+    v[2] ^= outlen == 8 ? 0xee : 0xff;
+    
+    for (o = 0; o < outlen; o += 4) {
+        if (o) v[1] ^= 0xdd;
+        for (r = 0; r < 4; r++) ref_round32(v);
+        b = v[1] ^ v[3];
+        for (j = 0; j < 4; j++) out[o + j] = (uint8_t) (b >> (8 * j));
+    }
+    
+}
+
+#endif
@@ -0,0 +1,211 @@
+/*
+ * halfsiphash.c
+ * HalfSipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * HalfSipHash is a SipHash variant operating on 32-bit words. It uses 64-bit key to produce 32-bit
+ * or 64-bit hash and is meant for 8-bit and 16-bit microcontrollers.
+ *  - https://github.com/veorq/SipHash
+ *
+ * The implementation does not utilize arithmetics wider than 16 bits.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * This library is strongly inspired by the SipHash_2_4 library for 8bit Atmel processors authored by Matthew Ford.
+ * Actually, all the core logic of the siphash algorithm is sourced from there. The following is the copyright
+ * disclosure of the SipHash_2_4 library author
+ *
+ * (c)2013 Forward Computing and Control Pty. Ltd. 
+ * www.forward.com.au
+ * This code may be freely used for both private and commercial use.
+ * Provide this copyright is maintained.
+ * 
+ */
+
+#include "halfsiphash.h"
+
+/*
+ * 32-bit words are held in 4 element arrays of uint8_t in big-endian order, the same way the
+ * byte-wise SipHash backend holds 64-bit ones.
+ *
+ * The following macros require that in the scope of their execution the variable int _i is defined.
+ */
+
+#define _msh_XOR32(v,v1) {                                  \
+    for (_i = 0; _i < 4; _i++) {                            \
+        (v)[_i] ^= (v1)[_i];                                \
+    }                                                       \
+}
+
+#define _msh_ADD32(v,s) {                                   \
+    uint16_t carry = 0;                                     \
+    for (_i = 3; _i >= 0; _i--) {                           \
+        carry += (v)[_i];                                   \
+        carry += (s)[_i];                                   \
+        (v)[_i] = carry;                                    \
+        carry = carry>>8;                                   \
+    }                                                       \
+}
+
+#define _msh_ROTL32_8(v) {                                  \
+    uint8_t vTemp = (v)[0];                                 \
+    (v)[0] = (v)[1];                                        \
+    (v)[1] = (v)[2];                                        \
+    (v)[2] = (v)[3];                                        \
+    (v)[3] = vTemp;                                         \
+}
+
+#define _msh_ROTL32_16(v) {                                 \
+    uint8_t vTemp;                                          \
+    for (_i = 0; _i < 2; _i++) {                            \
+        vTemp = (v)[_i];                                    \
+        (v)[_i] = (v)[_i+2];                                \
+        (v)[_i+2] = vTemp;                                  \
+    }                                                       \
+}
+
+#define _msh_ROTL32_xBITS(v,x) {                            \
+    uint8_t vTemp = (v)[0];                                 \
+    for (_i = 0; _i < 3; _i++) {                            \
+        (v)[_i] = ((v)[_i]<<(x)) | ((v)[_i+1]>>(8-(x)));    \
+    }                                                       \
+    (v)[3] = ((v)[3]<<(x)) | (vTemp>>(8-(x)));              \
+}
+
+#define _msh_ROTR32_xBITS(v,x) {                            \
+    uint8_t vTemp = (v)[3];                                 \
+    for (_i = 3; _i > 0; _i--) {                            \
+        (v)[_i] = ((v)[_i]>>(x)) | ((v)[_i-1]<<(8-(x)));    \
+    }                                                       \
+    (v)[0] = ((v)[0]>>(x)) | (vTemp<<(8-(x)));              \
+}
+
+#define _msh_ROL_7BITS(v) {                                 \
+    _msh_ROTL32_8(v);                                       \
+    _msh_ROTR32_xBITS(v,1);                                 \
+}
+
+#define _msh_ROL_13BITS(v) {                                \
+    _msh_ROTL32_16(v);                                      \
+    _msh_ROTR32_xBITS(v,3);                                 \
+}
+
+#define _msh_HALFSIPHASH_ROUND() {                          \
+    _msh_ADD32(v0, v1);                                     \
+    _msh_ADD32(v2, v3);                                     \
+    _msh_ROTL32_xBITS(v1, 5);                               \
+    _msh_ROTL32_8(v3);                                      \
+                                                            \
+    _msh_XOR32(v1, v0);                                     \
+    _msh_XOR32(v3, v2);                                     \
+    _msh_ROTL32_16(v0);                                     \
+                                                            \
+    _msh_ADD32(v2, v1);                                     \
+    _msh_ADD32(v0, v3);                                     \
+    _msh_ROL_13BITS(v1);                                    \
+    _msh_ROL_7BITS(v3);                                     \
+                                                            \
+    _msh_XOR32(v1, v2);                                     \
+    _msh_XOR32(v3, v0);                                     \
+    _msh_ROTL32_16(v2);                                     \
+}
+
+#define _msh_UPDATE_HASH(c) {                               \
+    msg_byte_counter++;                                     \
+    m[m_idx--] = c;                                         \
+    if (m_idx < 0) {                                        \
+        m_idx = 3;                                          \
+        _msh_XOR32(v3, m);                                  \
+        _msh_HALFSIPHASH_ROUND();                           \
+        _msh_HALFSIPHASH_ROUND();                           \
+        _msh_XOR32(v0, m);                                  \
+    }                                                       \
+}
+
+#define _msh_FINAL_ROUNDS() {                               \
+    _msh_HALFSIPHASH_ROUND();                               \
+    _msh_HALFSIPHASH_ROUND();                               \
+    _msh_HALFSIPHASH_ROUND();                               \
+    _msh_HALFSIPHASH_ROUND();                               \
+}
+
+/*
+ * Store v1 ^ v3 under p in little-endian order.
+ */
+#define _msh_STORE_OUTPUT(p) {                              \
+    for (_i = 0; _i < 4; _i++) {                            \
+        (p)[_i] = v1[3-_i] ^ v3[3-_i];                      \
+    }                                                       \
+}
+
+/*
+ * Computes HalfSipHash-2-4 with the output of out_len bytes, 4 or 8.
+ */
+static void _msh_halfsiphash(uint8_t *hash, const uint8_t *data, const size_t len, const uint8_t *key,
+    const int out_len) {
+    
+    uint8_t v0[4], v1[4], v2[4], v3[4];
+    uint8_t m[4], msg_byte_counter, msgLen;
+    int8_t m_idx;
+    int _i;
+    size_t i;
+    
+    for (_i = 0; _i < 4; _i++) {
+        v0[_i] = v2[_i] = key[3-_i];
+        v1[_i] = v3[_i] = key[7-_i];
+    }
+    
+    v2[0] ^= 0x6c; v2[1] ^= 0x79; v2[2] ^= 0x67; v2[3] ^= 0x65;
+    v3[0] ^= 0x74; v3[1] ^= 0x65; v3[2] ^= 0x64; v3[3] ^= 0x62;
+    
+    if (out_len == 8) v1[3] ^= 0xee;
+    
+    m_idx = 3;
+    msg_byte_counter = 0;
+    
+    for (i = 0; i < len; i++) _msh_UPDATE_HASH(data[i]);
+    
+    msgLen = msg_byte_counter;
+    
+    while (m_idx > 0) _msh_UPDATE_HASH(0);
+    
+    _msh_UPDATE_HASH(msgLen);
+    
+    v2[3] ^= out_len == 8 ? 0xee : 0xff;
+    _msh_FINAL_ROUNDS();
+    _msh_STORE_OUTPUT(hash);
+    
+    if (out_len == 4) return;
+    
+    v1[3] ^= 0xdd;
+    _msh_FINAL_ROUNDS();
+    _msh_STORE_OUTPUT(hash + 4);
+    
+}
+
+void halfsiphash(uint8_t *hash, const uint8_t *data, const size_t len, const uint8_t *key) {
+    _msh_halfsiphash(hash, data, len, key, 4);
+}
+
+void halfsiphash64(uint8_t *hash, const uint8_t *data, const size_t len, const uint8_t *key) {
+    _msh_halfsiphash(hash, data, len, key, 8);
+}
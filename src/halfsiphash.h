@@ -0,0 +1,70 @@
+/*
+ * halfsiphash.h
+ * HalfSipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * HalfSipHash is a SipHash variant operating on 32-bit words. It uses 64-bit key to produce 32-bit
+ * or 64-bit hash and is meant for 8-bit and 16-bit microcontrollers, where emulation of 64-bit
+ * words is too costly. Its security margin is lower than the one of SipHash, it should be used only
+ * where defense against hash-flooding is the goal.
+ *  - https://github.com/veorq/SipHash
+ *
+ * The implementation does not utilize arithmetics wider than 16 bits.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * This library is strongly inspired by the SipHash_2_4 library for 8bit Atmel processors authored by Matthew Ford.
+ * Actually, all the core logic of the siphash algorithm is sourced from there. The following is the copyright
+ * disclosure of the SipHash_2_4 library author
+ *
+ * (c)2013 Forward Computing and Control Pty. Ltd. 
+ * www.forward.com.au
+ * This code may be freely used for both private and commercial use.
+ * Provide this copyright is maintained.
+ * 
+ */
+#ifndef _HALFSIPHASH_H
+#define _HALFSIPHASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * HalfSipHash-2-4 of data under the 8 byte key. The 4 byte hash is stored in little-endian order.
+ */
+void halfsiphash(uint8_t *hash, const uint8_t *data, const size_t len, const uint8_t *key);
+
+/*
+ * HalfSipHash-2-4 with 64-bit output. The 8 byte hash is stored in little-endian order.
+ */
+void halfsiphash64(uint8_t *hash, const uint8_t *data, const size_t len, const uint8_t *key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -43,6 +43,268 @@
 
 #include "siphash.h"
 
+/*
+ * Each backend defines the same set of primitives operating on the state words v0..v3 and the message
+ * word m, all of the type siphash_word_t:
+ *
+ *  _msh_XOR64(v,v1)        v ^= v1
+ *  _msh_XOR_LSB(v,c)       xor the least significant byte of v with c
+ *  _msh_COPY64(v,v1)       v = v1
+ *  _msh_CLEAR64(v)         v = 0, may be a no-op if the backend overwrites m on every byte
+ *  _msh_SIPHASH_ROUND()    single SipRound over v0..v3
+ *  _msh_UPDATE_HASH(c,r)   absorb a single message byte, compressing full words with r rounds
+ *  _msh_LOAD_WORD(v,p)     load 8 message bytes from p into v
+ *  _msh_LOAD_TAIL0(v,n)    load the padded final word of an n byte message with no bytes left over
+ *  _msh_LOAD_TAIL4(v,p,n)  load the padded final word of an n byte message with 4 bytes left at p
+ *  _msh_INIT_STATE(key)    load the initial state under the 16 byte key
+ *  _msh_STORE_LE(p,v)      store v under p in little-endian order
+ *
+ * The following macros require that in the scope of their execution the variable int _i is defined.
+ */
+
+#if MSH_BACKEND == MSH_BACKEND_64BIT
+
+/*
+ * Native 64-bit backend. Words are held in uint64_t, so it shall be used only when the target
+ * provides 64-bit arithmetics in hardware.
+ */
+
+#define _msh_ROTL64(v,b) {                                  \
+    (v) = ((v) << (b)) | ((v) >> (64 - (b)));               \
+}
+
+#define _msh_LOAD_LE(p)                                     \
+    (((uint64_t) (p)[0])       | ((uint64_t) (p)[1] << 8) | \
+     ((uint64_t) (p)[2] << 16) | ((uint64_t) (p)[3] << 24) | \
+     ((uint64_t) (p)[4] << 32) | ((uint64_t) (p)[5] << 40) | \
+     ((uint64_t) (p)[6] << 48) | ((uint64_t) (p)[7] << 56))
+
+#define _msh_STORE_LE(p,v) {                                \
+    for (_i = 0; _i < 8; _i++) {                            \
+        (p)[_i] = (uint8_t) ((v) >> (_i << 3));             \
+    }                                                       \
+}
+
+#define _msh_XOR64(v,v1) {                                  \
+    (v) ^= (v1);                                            \
+}
+
+#define _msh_COPY64(v,v1) {                                 \
+    (v) = (v1);                                             \
+}
+
+#define _msh_CLEAR64(v) {                                   \
+    (v) = 0;                                                \
+}
+
+#define _msh_LOAD_WORD(v,p) {                               \
+    (v) = _msh_LOAD_LE(p);                                  \
+}
+
+#define _msh_LOAD_TAIL0(v,n) {                              \
+    (v) = (uint64_t) (n) << 56;                             \
+}
+
+#define _msh_LOAD_TAIL4(v,p,n) {                            \
+    (v) = (uint64_t) (n) << 56 | (uint64_t) (p)[0] |        \
+        (uint64_t) (p)[1] << 8 | (uint64_t) (p)[2] << 16 |  \
+        (uint64_t) (p)[3] << 24;                            \
+}
+
+#define _msh_XOR_LSB(v,c) {                                 \
+    (v) ^= (uint8_t) (c);                                   \
+}
+
+#define _msh_SIPHASH_ROUND() {                              \
+    v0 += v1;                                               \
+    v2 += v3;                                               \
+    _msh_ROTL64(v1, 13);                                    \
+    _msh_ROTL64(v3, 16);                                    \
+                                                            \
+    v1 ^= v0;                                               \
+    v3 ^= v2;                                               \
+    _msh_ROTL64(v0, 32);                                    \
+                                                            \
+    v2 += v1;                                               \
+    v0 += v3;                                               \
+    _msh_ROTL64(v1, 17);                                    \
+    _msh_ROTL64(v3, 21);                                    \
+                                                            \
+    v1 ^= v2;                                               \
+    v3 ^= v0;                                               \
+    _msh_ROTL64(v2, 32);                                    \
+}
+
+/*
+ * Bytes are gathered into m starting from the least significant one, m_idx counts down the same
+ * way as it does in the byte-wise backend.
+ */
+#define _msh_UPDATE_HASH(c,r) {                             \
+    msg_byte_counter++;                                     \
+    m |= (uint64_t) (c) << ((7 - m_idx) << 3);              \
+    m_idx--;                                                \
+    if (m_idx < 0) {                                        \
+        m_idx = 7;                                          \
+        _msh_COMPRESS(r);                                   \
+    }                                                       \
+}
+
+#define _msh_INIT_STATE(key) {                              \
+    v0 = UINT64_C(0x736f6d6570736575);                      \
+    v1 = UINT64_C(0x646f72616e646f6d);                      \
+    v2 = UINT64_C(0x6c7967656e657261);                      \
+    v3 = UINT64_C(0x7465646279746573);                      \
+                                                            \
+    m = _msh_LOAD_LE(key);                                  \
+    _msh_XOR64(v0, m);                                      \
+    _msh_XOR64(v2, m);                                      \
+                                                            \
+    m = _msh_LOAD_LE((key) + 8);                            \
+    _msh_XOR64(v1, m);                                      \
+    _msh_XOR64(v3, m);                                      \
+                                                            \
+    m = 0;                                                  \
+}
+
+#elif MSH_BACKEND == MSH_BACKEND_32BIT
+
+/*
+ * 32-bit limb backend. Words are held in pairs of uint32_t limbs, the most significant one first,
+ * and 64-bit additions and rotations are composed of 32-bit operations.
+ */
+
+#define _msh_LOAD32_LE(p)                                   \
+    (((uint32_t) (p)[0])       | ((uint32_t) (p)[1] << 8) | \
+     ((uint32_t) (p)[2] << 16) | ((uint32_t) (p)[3] << 24))
+
+#define _msh_STORE_LE(p,v) {                                \
+    for (_i = 0; _i < 4; _i++) {                            \
+        (p)[_i] = (uint8_t) ((v)[1] >> (_i << 3));          \
+        (p)[_i+4] = (uint8_t) ((v)[0] >> (_i << 3));        \
+    }                                                       \
+}
+
+#define _msh_XOR64(v,v1) {                                  \
+    (v)[0] ^= (v1)[0];                                      \
+    (v)[1] ^= (v1)[1];                                      \
+}
+
+#define _msh_COPY64(v,v1) {                                 \
+    (v)[0] = (v1)[0];                                       \
+    (v)[1] = (v1)[1];                                       \
+}
+
+#define _msh_CLEAR64(v) {                                   \
+    (v)[0] = (v)[1] = 0;                                    \
+}
+
+#define _msh_LOAD_WORD(v,p) {                               \
+    (v)[0] = _msh_LOAD32_LE((p) + 4);                       \
+    (v)[1] = _msh_LOAD32_LE(p);                             \
+}
+
+#define _msh_LOAD_TAIL0(v,n) {                              \
+    (v)[0] = (uint32_t) (n) << 24;                          \
+    (v)[1] = 0;                                             \
+}
+
+#define _msh_LOAD_TAIL4(v,p,n) {                            \
+    (v)[0] = (uint32_t) (n) << 24;                          \
+    (v)[1] = _msh_LOAD32_LE(p);                             \
+}
+
+#define _msh_XOR_LSB(v,c) {                                 \
+    (v)[1] ^= (uint8_t) (c);                                \
+}
+
+#define _msh_ADD64(v,s) {                                   \
+    uint32_t lo = (v)[1] + (s)[1];                          \
+    (v)[0] += (s)[0] + (lo < (v)[1]);                       \
+    (v)[1] = lo;                                            \
+}
+
+#define _msh_ROTL64_xBITS(v,x) {                            \
+    uint32_t hi = (v)[0];                                   \
+    (v)[0] = (hi << (x)) | ((v)[1] >> (32 - (x)));          \
+    (v)[1] = ((v)[1] << (x)) | (hi >> (32 - (x)));          \
+}
+
+#define _msh_ROTL64_32(v) {                                 \
+    uint32_t hi = (v)[0];                                   \
+    (v)[0] = (v)[1];                                        \
+    (v)[1] = hi;                                            \
+}
+
+#define _msh_SIPHASH_ROUND() {                              \
+    _msh_ADD64(v0, v1);                                     \
+    _msh_ADD64(v2, v3);                                     \
+    _msh_ROTL64_xBITS(v1, 13);                              \
+    _msh_ROTL64_xBITS(v3, 16);                              \
+                                                            \
+    _msh_XOR64(v1, v0);                                     \
+    _msh_XOR64(v3, v2);                                     \
+    _msh_ROTL64_32(v0);                                     \
+                                                            \
+    _msh_ADD64(v2, v1);                                     \
+    _msh_ADD64(v0, v3);                                     \
+    _msh_ROTL64_xBITS(v1, 17);                              \
+    _msh_ROTL64_xBITS(v3, 21);                              \
+                                                            \
+    _msh_XOR64(v1, v2);                                     \
+    _msh_XOR64(v3, v0);                                     \
+    _msh_ROTL64_32(v2);                                     \
+}
+
+/*
+ * The first four message bytes go to the low limb, the remaining ones to the high limb.
+ */
+#define _msh_UPDATE_HASH(c,r) {                             \
+    msg_byte_counter++;                                     \
+    if (m_idx > 3) {                                        \
+        m[1] |= (uint32_t) (c) << ((7 - m_idx) << 3);       \
+    } else {                                                \
+        m[0] |= (uint32_t) (c) << ((3 - m_idx) << 3);       \
+    }                                                       \
+    m_idx--;                                                \
+    if (m_idx < 0) {                                        \
+        m_idx = 7;                                          \
+        _msh_COMPRESS(r);                                   \
+    }                                                       \
+}
+
+#define _msh_INIT_STATE(key) {                              \
+    v0[0] = 0x736f6d65UL; v0[1] = 0x70736575UL;             \
+    v1[0] = 0x646f7261UL; v1[1] = 0x6e646f6dUL;             \
+    v2[0] = 0x6c796765UL; v2[1] = 0x6e657261UL;             \
+    v3[0] = 0x74656462UL; v3[1] = 0x79746573UL;             \
+                                                            \
+    m[0] = _msh_LOAD32_LE((key) + 4);                       \
+    m[1] = _msh_LOAD32_LE(key);                             \
+    _msh_XOR64(v0, m);                                      \
+    _msh_XOR64(v2, m);                                      \
+                                                            \
+    m[0] = _msh_LOAD32_LE((key) + 12);                      \
+    m[1] = _msh_LOAD32_LE((key) + 8);                       \
+    _msh_XOR64(v1, m);                                      \
+    _msh_XOR64(v3, m);                                      \
+                                                            \
+    m[0] = m[1] = 0;                                        \
+}
+
+#else
+
+/*
+ * Byte-wise backend. Words are held in 8 element arrays of uint8_t in big-endian order, so no
+ * arithmetics wider than 16 bits is required.
+ */
+
+static const uint8_t _msh_iv[4][8] = {
+    {0x73, 0x6f, 0x6d, 0x65, 0x70, 0x73, 0x65, 0x75},
+    {0x64, 0x6f, 0x72, 0x61, 0x6e, 0x64, 0x6f, 0x6d},
+    {0x6c, 0x79, 0x67, 0x65, 0x6e, 0x65, 0x72, 0x61},
+    {0x74, 0x65, 0x64, 0x62, 0x79, 0x74, 0x65, 0x73}
+};
+
 static void _msh_rotl64_16(uint8_t *v) {
     uint8_t v0 = v[0];
     uint8_t v1 = v[1];
@@ -64,16 +326,46 @@ static void _msh_reverse64(uint8_t *x) {
     }
 }
 
-/*
- * The following macros require that in the scope of their execution the variable int _i is defined.
- */
-
 #define _msh_XOR64(v,v1) {                                  \
     for (_i = 0; _i < 8; _i++) {                            \
         v[_i] ^= v1[_i];                                    \
     }                                                       \
 }
 
+#define _msh_XOR_LSB(v,c) {                                 \
+    (v)[7] ^= (c);                                          \
+}
+
+#define _msh_COPY64(v,v1) {                                 \
+    memcpy(v, v1, 8);                                       \
+}
+
+#define _msh_CLEAR64(v) {}
+
+#define _msh_LOAD_WORD(v,p) {                               \
+    for (_i = 0; _i < 8; _i++) {                            \
+        (v)[7-_i] = (p)[_i];                                \
+    }                                                       \
+}
+
+#define _msh_LOAD_TAIL0(v,n) {                              \
+    memset(v, 0, 8);                                        \
+    (v)[0] = (n);                                           \
+}
+
+#define _msh_LOAD_TAIL4(v,p,n) {                            \
+    _msh_LOAD_TAIL0(v, n);                                  \
+    for (_i = 0; _i < 4; _i++) {                            \
+        (v)[7-_i] = (p)[_i];                                \
+    }                                                       \
+}
+
+#define _msh_STORE_LE(p,v) {                                \
+    for (_i = 0; _i < 8; _i++) {                            \
+        (p)[_i] = (v)[7-_i];                                \
+    }                                                       \
+}
+
 #define _msh_ROTL64_16(v) {                                 \
     uint8_t v0 = v[0];                                      \
     uint8_t v1 = v[1];                                      \
@@ -155,61 +447,537 @@ static void _msh_reverse64(uint8_t *x) {
     _msh_ROTL64_32(v2);                                     \
 }
 
-#define _msh_UPDATE_HASH(c) {                               \
+#define _msh_UPDATE_HASH(c,r) {                             \
     msg_byte_counter++;                                     \
     m[m_idx--] = c;                                         \
     if (m_idx < 0) {                                        \
         m_idx = 7;                                          \
-        _msh_XOR64(v3, m);                                  \
-        _msh_SIPHASH_ROUND();                               \
-        _msh_SIPHASH_ROUND();                               \
-        _msh_XOR64(v0, m);                                  \
+        _msh_COMPRESS(r);                                   \
+    }                                                       \
+}
+
+#define _msh_INIT_STATE(key) {                              \
+    memcpy(v0, _msh_iv[0], 8);                              \
+    memcpy(v1, _msh_iv[1], 8);                              \
+    memcpy(v2, _msh_iv[2], 8);                              \
+    memcpy(v3, _msh_iv[3], 8);                              \
+                                                            \
+    memcpy(m, key, 8);                                      \
+    _msh_reverse64(m);                                      \
+    _msh_XOR64(v0, m);                                      \
+    _msh_XOR64(v2, m);                                      \
+                                                            \
+    memcpy(m, (key) + 8, 8);                                \
+    _msh_reverse64(m);                                      \
+    _msh_XOR64(v1, m);                                      \
+    _msh_XOR64(v3, m);                                      \
+}
+
+#endif
+
+#ifdef MSH_INSTRUMENT
+
+/*
+ * Storage class of the counters. Thread-local by default, may be defined empty on targets with no
+ * threads or no thread-local storage.
+ */
+#ifndef MSH_THREAD_LOCAL
+#if defined(__GNUC__)
+#define MSH_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define MSH_THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define MSH_THREAD_LOCAL _Thread_local
+#else
+#define MSH_THREAD_LOCAL
+#endif
+#endif
+
+static MSH_THREAD_LOCAL siphash_stats _msh_stats;
+
+/*
+ * Returns the histogram bucket of the value, taken as uint64_t so that cycle counts are never
+ * truncated.
+ */
+static unsigned int _msh_stats_bucket(uint64_t n) {
+    
+    unsigned int b = 0;
+    
+    while (n && b < SIPHASH_STATS_BUCKETS - 1) {
+        n >>= 1;
+        b++;
+    }
+    
+    return b;
+    
+}
+
+#ifdef MSH_INSTRUMENT_TSC
+
+#if !defined(__GNUC__) || !(defined(__x86_64__) || defined(__i386__))
+#error "MSH_INSTRUMENT_TSC requires GCC compatible compiler targeting x86"
+#endif
+
+/* Start of the hash in progress; hashes computed by this file don't nest. */
+static MSH_THREAD_LOCAL uint64_t _msh_tsc;
+
+static uint64_t _msh_rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+    return (uint64_t) hi << 32 | lo;
+}
+
+#define _msh_STAT_BEGIN() {                                 \
+    _msh_tsc = _msh_rdtsc();                                \
+}
+
+#define _msh_STAT_LATENCY() {                               \
+    uint64_t _t = _msh_rdtsc() - _msh_tsc;                  \
+    _msh_stats.cycles += _t;                                \
+    _msh_stats.latency[_msh_stats_bucket(_t)]++;            \
+}
+
+#else
+
+#define _msh_STAT_BEGIN() {}
+#define _msh_STAT_LATENCY() {}
+
+#endif
+
+#define _msh_STAT_ADD(field,n) {                            \
+    _msh_stats.field += (unsigned long) (n);                \
+}
+
+/*
+ * Account a complete hash of a len byte message, begun by _msh_STAT_BEGIN().
+ */
+#define _msh_STAT_HASH(len) {                               \
+    _msh_stats.calls++;                                     \
+    _msh_stats.bytes += (unsigned long) (len);              \
+    _msh_stats.length[_msh_stats_bucket(len)]++;            \
+    _msh_STAT_LATENCY();                                    \
+}
+
+#else
+
+#define _msh_STAT_BEGIN() {}
+#define _msh_STAT_ADD(field,n) {}
+#define _msh_STAT_HASH(len) {}
+
+#endif
+
+/*
+ * _msh_ROUNDS(n) expands to n SipRounds, without any loop.
+ */
+#define _msh_ROUNDS_1() {                                   \
+    _msh_SIPHASH_ROUND();                                   \
+}
+#define _msh_ROUNDS_2() { _msh_ROUNDS_1(); _msh_ROUNDS_1(); }
+#define _msh_ROUNDS_3() { _msh_ROUNDS_2(); _msh_ROUNDS_1(); }
+#define _msh_ROUNDS_4() { _msh_ROUNDS_2(); _msh_ROUNDS_2(); }
+#define _msh_ROUNDS_5() { _msh_ROUNDS_4(); _msh_ROUNDS_1(); }
+#define _msh_ROUNDS_6() { _msh_ROUNDS_4(); _msh_ROUNDS_2(); }
+#define _msh_ROUNDS_7() { _msh_ROUNDS_4(); _msh_ROUNDS_3(); }
+#define _msh_ROUNDS_8() { _msh_ROUNDS_4(); _msh_ROUNDS_4(); }
+
+#define _msh_ROUNDS_(n) _msh_ROUNDS_##n()
+#define _msh_ROUNDS(n) _msh_ROUNDS_(n)
+
+/*
+ * Absorb the complete message word m with r compression rounds.
+ */
+#define _msh_COMPRESS(r) {                                  \
+    _msh_STAT_ADD(compress_rounds, r);                      \
+    _msh_XOR64(v3, m);                                      \
+    _msh_ROUNDS(r);                                         \
+    _msh_XOR64(v0, m);                                      \
+    _msh_CLEAR64(m);                                        \
+}
+
+/*
+ * Pad the message and absorb its length with c compression rounds. Requires uint8_t msgLen in the
+ * scope.
+ */
+#define _msh_PAD(c) {                                       \
+    msgLen = msg_byte_counter;                              \
+                                                            \
+    while (m_idx > 0) _msh_UPDATE_HASH(0, c);               \
+                                                            \
+    _msh_UPDATE_HASH(msgLen, c);                            \
+}
+
+/*
+ * Pad the message and compute the 64-bit hash with c compression and d finalization rounds.
+ */
+#define _msh_FINALIZE_64(hash,c,d) {                        \
+    _msh_PAD(c);                                            \
+    _msh_SQUEEZE_64(hash, d);                               \
+}
+
+/*
+ * Compute the 64-bit hash from the state which has absorbed the padded message.
+ */
+#define _msh_SQUEEZE_64(hash,d) {                           \
+    _msh_STAT_ADD(final_rounds, d);                         \
+    _msh_XOR_LSB(v2, 0xff);                                 \
+    _msh_ROUNDS(d);                                         \
+                                                            \
+    _msh_COPY64(m, v0);                                     \
+    _msh_XOR64(m, v1);                                      \
+    _msh_XOR64(m, v2);                                      \
+    _msh_XOR64(m, v3);                                      \
+                                                            \
+    _msh_STORE_LE(hash, m);                                 \
+}
+
+/*
+ * The 128-bit variant tweaks the finalization constant and runs a second finalization pass for
+ * the upper half of the hash.
+ */
+#define _msh_FINALIZE_128(hash,c,d) {                       \
+    _msh_PAD(c);                                            \
+                                                            \
+    _msh_STAT_ADD(final_rounds, 2 * (d));                   \
+    _msh_XOR_LSB(v2, 0xee);                                 \
+    _msh_ROUNDS(d);                                         \
+                                                            \
+    _msh_COPY64(m, v0);                                     \
+    _msh_XOR64(m, v1);                                      \
+    _msh_XOR64(m, v2);                                      \
+    _msh_XOR64(m, v3);                                      \
+                                                            \
+    _msh_STORE_LE(hash, m);                                 \
+                                                            \
+    _msh_XOR_LSB(v1, 0xdd);                                 \
+    _msh_ROUNDS(d);                                         \
+                                                            \
+    _msh_COPY64(m, v0);                                     \
+    _msh_XOR64(m, v1);                                      \
+    _msh_XOR64(m, v2);                                      \
+    _msh_XOR64(m, v3);                                      \
+                                                            \
+    _msh_STORE_LE((hash) + 8, m);                           \
+}
+
+#define _msh_FINALIZE_(hash,c,d,bits) _msh_FINALIZE_##bits(hash, c, d)
+#define _msh_FINALIZE(hash,c,d,bits) _msh_FINALIZE_(hash, c, d, bits)
+
+/*
+ * The initial state of the 128-bit variant differs in v1.
+ */
+#define _msh_TWEAK_64() {}
+#define _msh_TWEAK_128() {                                  \
+    _msh_XOR_LSB(v1, 0xee);                                 \
+}
+
+#define _msh_TWEAK_(bits) _msh_TWEAK_##bits()
+#define _msh_TWEAK(bits) _msh_TWEAK_(bits)
+
+/*
+ * Absorb whole 8 byte words of the message, advancing p and decreasing left accordingly. Shall be
+ * used only on word boundary, i.e. when m_idx equals 7.
+ */
+#define _msh_ABSORB_WORDS(p,left,c) {                       \
+    while ((left) >= 8) {                                   \
+        _msh_LOAD_WORD(m, p);                               \
+        _msh_COMPRESS(c);                                   \
+        msg_byte_counter += 8;                              \
+        (p) += 8;                                           \
+        (left) -= 8;                                        \
+    }                                                       \
+}
+
+/*
+ * Absorb bytes of the message at any position, completing the word left partial by the preceding
+ * data first, and carrying the trailing bytes over in m.
+ */
+#define _msh_ABSORB(p,left,c) {                             \
+    while ((left) > 0 && m_idx != 7) {                      \
+        _msh_UPDATE_HASH(*(p), c);                          \
+        (p)++;                                              \
+        (left)--;                                           \
     }                                                       \
+                                                            \
+    if (m_idx == 7) _msh_ABSORB_WORDS(p, left, c);          \
+                                                            \
+    while ((left) > 0) {                                    \
+        _msh_UPDATE_HASH(*(p), c);                          \
+        (p)++;                                              \
+        (left)--;                                           \
+    }                                                       \
+}
+
+#define _msh_LOAD_KEY(key) {                                \
+    _msh_COPY64(v0, (key)->v0);                             \
+    _msh_COPY64(v1, (key)->v1);                             \
+    _msh_COPY64(v2, (key)->v2);                             \
+    _msh_COPY64(v3, (key)->v3);                             \
+    _msh_CLEAR64(m);                                        \
+}
+
+#define _msh_LOAD_CTX(ctx) {                                \
+    _msh_COPY64(v0, (ctx)->v0);                             \
+    _msh_COPY64(v1, (ctx)->v1);                             \
+    _msh_COPY64(v2, (ctx)->v2);                             \
+    _msh_COPY64(v3, (ctx)->v3);                             \
+    _msh_COPY64(m, (ctx)->m);                               \
+    m_idx = (ctx)->m_idx;                                   \
+    msg_byte_counter = (ctx)->msg_byte_counter;             \
+}
+
+#define _msh_STORE_CTX(ctx) {                               \
+    _msh_COPY64((ctx)->v0, v0);                             \
+    _msh_COPY64((ctx)->v1, v1);                             \
+    _msh_COPY64((ctx)->v2, v2);                             \
+    _msh_COPY64((ctx)->v3, v3);                             \
+    _msh_COPY64((ctx)->m, m);                               \
+    (ctx)->m_idx = m_idx;                                   \
+    (ctx)->msg_byte_counter = msg_byte_counter;             \
 }
 
-void siphash(uint8_t *hash, const uint8_t *data, const size_t len, const uint8_t *key) {
+void siphash_key_init(siphash_key_t *prepared, const uint8_t *key) {
     
-    uint8_t v0[] = {0x73, 0x6f, 0x6d, 0x65, 0x70, 0x73, 0x65, 0x75};
-    uint8_t v1[] = {0x64, 0x6f, 0x72, 0x61, 0x6e, 0x64, 0x6f, 0x6d};
-    uint8_t v2[] = {0x6c, 0x79, 0x67, 0x65, 0x6e, 0x65, 0x72, 0x61};
-    uint8_t v3[] = {0x74, 0x65, 0x64, 0x62, 0x79, 0x74, 0x65, 0x73};
-    uint8_t m[8], msg_byte_counter;
+    siphash_word_t v0, v1, v2, v3, m;
+    int _i;
+    
+    /* Only the byte-wise backend loops here. */
+    (void) _i;
+    
+    _msh_INIT_STATE(key);
+    
+    _msh_COPY64(prepared->v0, v0);
+    _msh_COPY64(prepared->v1, v1);
+    _msh_COPY64(prepared->v2, v2);
+    _msh_COPY64(prepared->v3, v3);
+    
+}
+
+/*
+ * Defines SipHash-c-d entry points name() and name_with_key() producing hashes of the given bits.
+ */
+#define _msh_DEFINE_SIPHASH(name,c,d,bits)                                                      \
+void name##_with_key(uint8_t *hash, const uint8_t *data, const size_t len,                      \
+    const siphash_key_t *key) {                                                                 \
+                                                                                                \
+    siphash_word_t v0, v1, v2, v3, m;                                                           \
+    uint8_t msg_byte_counter, msgLen;                                                           \
+    int8_t m_idx;                                                                               \
+    int _i;                                                                                     \
+    const uint8_t *p = data;                                                                    \
+    size_t left = len;                                                                          \
+                                                                                                \
+    _msh_STAT_BEGIN();                                                                          \
+    _msh_LOAD_KEY(key);                                                                         \
+    _msh_TWEAK(bits);                                                                           \
+                                                                                                \
+    m_idx = 7;                                                                                  \
+    msg_byte_counter = 0;                                                                       \
+                                                                                                \
+    _msh_ABSORB_WORDS(p, left, c);                                                              \
+                                                                                                \
+    while (left > 0) {                                                                          \
+        _msh_UPDATE_HASH(*p, c);                                                                \
+        p++;                                                                                    \
+        left--;                                                                                 \
+    }                                                                                           \
+                                                                                                \
+    _msh_FINALIZE(hash, c, d, bits);                                                            \
+    _msh_STAT_HASH(len);                                                                        \
+                                                                                                \
+}                                                                                               \
+                                                                                                \
+void name(uint8_t *hash, const uint8_t *data, const size_t len, const uint8_t *key) {           \
+                                                                                                \
+    siphash_key_t prepared;                                                                     \
+                                                                                                \
+    siphash_key_init(&prepared, key);                                                           \
+    name##_with_key(hash, data, len, &prepared);                                                \
+                                                                                                \
+}
+
+_msh_DEFINE_SIPHASH(siphash, 2, 4, 64)
+_msh_DEFINE_SIPHASH(siphash13, 1, 3, 64)
+_msh_DEFINE_SIPHASH(siphash48, 4, 8, 64)
+_msh_DEFINE_SIPHASH(siphash128, 2, 4, 128)
+
+/*
+ * Fixed length SipHash-2-4. With the length known, the padded final word is built directly and the
+ * whole message schedule is unrolled, no byte counting or padding loop left.
+ */
+void siphash_u32(uint8_t *hash, const uint8_t *data, const siphash_key_t *key) {
+    
+    siphash_word_t v0, v1, v2, v3, m;
+    int _i;
+    
+    _msh_STAT_BEGIN();
+    _msh_LOAD_KEY(key);
+    
+    _msh_LOAD_TAIL4(m, data, 4);
+    _msh_COMPRESS(2);
+    
+    _msh_SQUEEZE_64(hash, 4);
+    _msh_STAT_HASH(4);
+    
+}
+
+void siphash_u64(uint8_t *hash, const uint8_t *data, const siphash_key_t *key) {
+    
+    siphash_word_t v0, v1, v2, v3, m;
+    int _i;
+    
+    _msh_STAT_BEGIN();
+    _msh_LOAD_KEY(key);
+    
+    _msh_LOAD_WORD(m, data);
+    _msh_COMPRESS(2);
+    _msh_LOAD_TAIL0(m, 8);
+    _msh_COMPRESS(2);
+    
+    _msh_SQUEEZE_64(hash, 4);
+    _msh_STAT_HASH(8);
+    
+}
+
+void siphash_u128(uint8_t *hash, const uint8_t *data, const siphash_key_t *key) {
+    
+    siphash_word_t v0, v1, v2, v3, m;
+    int _i;
+    
+    _msh_STAT_BEGIN();
+    _msh_LOAD_KEY(key);
+    
+    _msh_LOAD_WORD(m, data);
+    _msh_COMPRESS(2);
+    _msh_LOAD_WORD(m, data + 8);
+    _msh_COMPRESS(2);
+    _msh_LOAD_TAIL0(m, 16);
+    _msh_COMPRESS(2);
+    
+    _msh_SQUEEZE_64(hash, 4);
+    _msh_STAT_HASH(16);
+    
+}
+
+void siphash24(uint8_t *hash, const uint8_t *data, const size_t len, const uint8_t *key) {
+    siphash(hash, data, len, key);
+}
+
+void siphash24_with_key(uint8_t *hash, const uint8_t *data, const size_t len, const siphash_key_t *key) {
+    siphash_with_key(hash, data, len, key);
+}
+
+void siphash_init(siphash_ctx *ctx, const uint8_t *key) {
+    
+    siphash_key_t prepared;
+    
+    siphash_key_init(&prepared, key);
+    siphash_init_with_key(ctx, &prepared);
+    
+}
+
+void siphash_init_with_key(siphash_ctx *ctx, const siphash_key_t *key) {
+    
+    siphash_word_t v0, v1, v2, v3, m;
+    uint8_t msg_byte_counter;
     int8_t m_idx;
-    int _i, i;
     
-    memcpy(m, key, 8);
-    _msh_reverse64(m);
-    _msh_XOR64(v0, m);
-    _msh_XOR64(v2, m);
+    _msh_LOAD_KEY(key);
     
-    memcpy(m, key+8, 8);
-    _msh_reverse64(m);
-    _msh_XOR64(v1, m);
-    _msh_XOR64(v3, m);
+    /* The byte-wise backend does not clear m, but the context keeps it. */
+    memset(&m, 0, sizeof(m));
     
     m_idx = 7;
     msg_byte_counter = 0;
     
-    for (i = 0; i < len; i++) _msh_UPDATE_HASH(data[i]);
+    _msh_STORE_CTX(ctx);
+    
+}
+
+void siphash_update(siphash_ctx *ctx, const uint8_t *data, size_t len) {
+    
+    siphash_word_t v0, v1, v2, v3, m;
+    uint8_t msg_byte_counter;
+    int8_t m_idx;
+    int _i;
+    
+    (void) _i;
     
-    uint8_t msgLen = msg_byte_counter;
+    _msh_LOAD_CTX(ctx);
     
-    while (m_idx > 0) _msh_UPDATE_HASH(0);
+    _msh_STAT_ADD(bytes, len);
+    _msh_ABSORB(data, len, 2);
     
-    _msh_UPDATE_HASH(msgLen);
+    _msh_STORE_CTX(ctx);
     
-    v2[7] ^= 0xff;
-    _msh_SIPHASH_ROUND();
-    _msh_SIPHASH_ROUND();
-    _msh_SIPHASH_ROUND();
-    _msh_SIPHASH_ROUND();
+}
+
+void siphash_final(siphash_ctx *ctx, uint8_t *hash) {
     
-    _msh_XOR64(v0, v1);
-    _msh_XOR64(v0, v2);
-    _msh_XOR64(v0, v3);
+    siphash_word_t v0, v1, v2, v3, m;
+    uint8_t msg_byte_counter, msgLen;
+    int8_t m_idx;
+    int _i;
     
-    memcpy(hash, v0, 8);
+    _msh_LOAD_CTX(ctx);
     
-    _msh_reverse64(hash);
+    _msh_FINALIZE(hash, 2, 4, 64);
+    
+    _msh_STAT_ADD(calls, 1);
+    _msh_STAT_ADD(streams, 1);
     
 }
+
+#ifdef MSH_HAVE_IOVEC
+
+void siphash_v_with_key(uint8_t *hash, const struct iovec *iov, const int iovcnt,
+    const siphash_key_t *key) {
+    
+    siphash_word_t v0, v1, v2, v3, m;
+    uint8_t msg_byte_counter, msgLen;
+    int8_t m_idx;
+    int i, _i;
+    const uint8_t *p;
+    size_t left, total = 0;
+    
+    _msh_STAT_BEGIN();
+    _msh_LOAD_KEY(key);
+    
+    m_idx = 7;
+    msg_byte_counter = 0;
+    
+    /* The state stays in locals across the segments, partial words carried over in m. */
+    for (i = 0; i < iovcnt; i++) {
+        p = (const uint8_t *) iov[i].iov_base;
+        left = iov[i].iov_len;
+        total += left;
+        _msh_ABSORB(p, left, 2);
+    }
+    
+    _msh_FINALIZE(hash, 2, 4, 64);
+    _msh_STAT_HASH(total);
+    (void) total;
+    
+}
+
+void siphash_v(uint8_t *hash, const struct iovec *iov, const int iovcnt, const uint8_t *key) {
+    
+    siphash_key_t prepared;
+    
+    siphash_key_init(&prepared, key);
+    siphash_v_with_key(hash, iov, iovcnt, &prepared);
+    
+}
+
+#endif
+
+#ifdef MSH_INSTRUMENT
+
+void siphash_stats_snapshot(siphash_stats *stats) {
+    *stats = _msh_stats;
+}
+
+void siphash_stats_reset(void) {
+    memset(&_msh_stats, 0, sizeof(_msh_stats));
+}
+
+#endif
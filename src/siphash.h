@@ -47,6 +47,154 @@
 #include <stdint.h>
 #include <string.h>
 
+/*
+ * Backend selection. The byte-wise backend emulates 64-bit words on arrays of uint8_t and is meant
+ * for small microcontrollers, the 32-bit backend holds words in pairs of uint32_t limbs and suits
+ * 32-bit MCUs, the 64-bit backend uses native uint64_t arithmetics. The backend can be forced by
+ * defining MSH_BACKEND (e.g. -DMSH_BACKEND=8), otherwise it is picked after the pointer width of
+ * the target.
+ */
+#define MSH_BACKEND_8BIT 8
+#define MSH_BACKEND_32BIT 32
+#define MSH_BACKEND_64BIT 64
+
+#ifndef MSH_BACKEND
+#if defined(UINT64_MAX) && defined(UINTPTR_MAX) && UINTPTR_MAX > 0xffffffffu
+#define MSH_BACKEND MSH_BACKEND_64BIT
+#elif defined(UINTPTR_MAX) && UINTPTR_MAX >= 0xffffffffu
+#define MSH_BACKEND MSH_BACKEND_32BIT
+#else
+#define MSH_BACKEND MSH_BACKEND_8BIT
+#endif
+#endif
+
+#if MSH_BACKEND != MSH_BACKEND_8BIT && MSH_BACKEND != MSH_BACKEND_32BIT && MSH_BACKEND != MSH_BACKEND_64BIT
+#error "Unsupported MSH_BACKEND"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 64-bit word as held by the selected backend.
+ */
+#if MSH_BACKEND == MSH_BACKEND_64BIT
+typedef uint64_t siphash_word_t;
+#elif MSH_BACKEND == MSH_BACKEND_32BIT
+typedef uint32_t siphash_word_t[2];
+#else
+typedef uint8_t siphash_word_t[8];
+#endif
+
+/*
+ * Initial state derived from the 16 byte key. Preparing it once saves the key setup on every hash
+ * computed under the same key. Shall be treated as opaque.
+ */
+typedef struct {
+    siphash_word_t v0, v1, v2, v3;
+} siphash_key_t;
+
+/*
+ * State of the incremental hash computation. Shall be treated as opaque.
+ */
+typedef struct {
+    siphash_word_t v0, v1, v2, v3;
+    siphash_word_t m;
+    int8_t m_idx;
+    uint8_t msg_byte_counter;
+} siphash_ctx;
+
 void siphash(uint8_t *hash, const uint8_t *data, const size_t len, const uint8_t *key);
 
+void siphash_key_init(siphash_key_t *prepared, const uint8_t *key);
+void siphash_with_key(uint8_t *hash, const uint8_t *data, const size_t len, const siphash_key_t *key);
+
+/*
+ * Variants with other numbers of compression and finalization rounds. SipHash-1-3 trades security
+ * margin for speed, SipHash-4-8 is the conservative one. siphash24() is the same as siphash().
+ */
+void siphash13(uint8_t *hash, const uint8_t *data, const size_t len, const uint8_t *key);
+void siphash13_with_key(uint8_t *hash, const uint8_t *data, const size_t len, const siphash_key_t *key);
+void siphash24(uint8_t *hash, const uint8_t *data, const size_t len, const uint8_t *key);
+void siphash24_with_key(uint8_t *hash, const uint8_t *data, const size_t len, const siphash_key_t *key);
+void siphash48(uint8_t *hash, const uint8_t *data, const size_t len, const uint8_t *key);
+void siphash48_with_key(uint8_t *hash, const uint8_t *data, const size_t len, const siphash_key_t *key);
+
+/*
+ * SipHash-2-4 with 128-bit output, stored under hash as 16 bytes in little-endian order.
+ */
+void siphash128(uint8_t *hash, const uint8_t *data, const size_t len, const uint8_t *key);
+void siphash128_with_key(uint8_t *hash, const uint8_t *data, const size_t len, const siphash_key_t *key);
+
+/*
+ * SipHash-2-4 of messages of fixed lengths of 4, 8 and 16 bytes, such as integer or UUID keys of
+ * hash tables. The hash is the same as the one of siphash_with_key() over the same bytes.
+ */
+void siphash_u32(uint8_t *hash, const uint8_t *data, const siphash_key_t *key);
+void siphash_u64(uint8_t *hash, const uint8_t *data, const siphash_key_t *key);
+void siphash_u128(uint8_t *hash, const uint8_t *data, const siphash_key_t *key);
+
+/*
+ * Incremental interface. Any split of the message among siphash_update() calls yields the same hash
+ * as siphash() over the whole message.
+ */
+void siphash_init(siphash_ctx *ctx, const uint8_t *key);
+void siphash_init_with_key(siphash_ctx *ctx, const siphash_key_t *key);
+void siphash_update(siphash_ctx *ctx, const uint8_t *data, size_t len);
+void siphash_final(siphash_ctx *ctx, uint8_t *hash);
+
+/*
+ * Scatter-gather interface, hashing the concatenation of iovcnt segments in place. Available on
+ * POSIX systems, or elsewhere with MSH_IOVEC defined if struct iovec is provided by <sys/uio.h>.
+ */
+#if defined(MSH_IOVEC) || defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))
+#define MSH_HAVE_IOVEC
+#include <sys/uio.h>
+
+void siphash_v(uint8_t *hash, const struct iovec *iov, const int iovcnt, const uint8_t *key);
+void siphash_v_with_key(uint8_t *hash, const struct iovec *iov, const int iovcnt,
+    const siphash_key_t *key);
+#endif
+
+/*
+ * Instrumentation, compiled in only with MSH_INSTRUMENT defined; MSH_INSTRUMENT_TSC adds the latency
+ * histogram, measured with rdtsc on x86. The counters are kept per thread (see MSH_THREAD_LOCAL in
+ * siphash.c) and cover the hashes computed by the calling thread since the last reset.
+ *
+ * Bucket 0 of the histograms counts the zero values, bucket i > 0 the values from 2^(i-1) up to
+ * 2^i - 1, the last bucket everything above. Streamed hashes count in bytes and calls, but not in
+ * the histograms.
+ */
+#if defined(MSH_INSTRUMENT_TSC) && !defined(MSH_INSTRUMENT)
+#define MSH_INSTRUMENT
+#endif
+
+#ifdef MSH_INSTRUMENT
+#define SIPHASH_STATS_BUCKETS 32
+
+typedef struct {
+    /* Hashes computed, of them by siphash_final(). */
+    unsigned long calls;
+    unsigned long streams;
+    /* Message bytes absorbed. */
+    unsigned long bytes;
+    /* SipRounds executed by the compression of the message words and by the finalization. */
+    unsigned long compress_rounds;
+    unsigned long final_rounds;
+    /* Message lengths in bytes. */
+    unsigned long length[SIPHASH_STATS_BUCKETS];
+    /* Cycles spent, in total and per hash. MSH_INSTRUMENT_TSC only. */
+    uint64_t cycles;
+    unsigned long latency[SIPHASH_STATS_BUCKETS];
+} siphash_stats;
+
+void siphash_stats_snapshot(siphash_stats *stats);
+void siphash_stats_reset(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,199 @@
+/*
+ * siphash.hpp
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Header-only C++17 wrapper. Provides constexpr SipHash-2-4 for hashing under keys known at compile
+ * time, runtime overloads forwarding to the C implementation and a std::hash compatible functor.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+#ifndef _SIPHASH_HPP
+#define _SIPHASH_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#if __cplusplus >= 202002L
+#include <span>
+#include <type_traits>
+#endif
+
+#include "siphash.h"
+
+namespace msh {
+
+using key_type = std::array<std::uint8_t, 16>;
+
+namespace detail {
+
+constexpr std::uint64_t rotl(const std::uint64_t x, const int b) noexcept {
+    return (x << b) | (x >> (64 - b));
+}
+
+/*
+ * Load up to 8 bytes in little-endian order. Byte may be any type convertible to std::uint8_t,
+ * char and std::byte included.
+ */
+template <typename Byte>
+constexpr std::uint64_t load_le(const Byte *p, const std::size_t len) noexcept {
+    std::uint64_t word = 0;
+    for (std::size_t i = 0; i < len; i++) {
+        word |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(p[i])) << (i << 3);
+    }
+    return word;
+}
+
+struct state {
+    
+    std::uint64_t v0, v1, v2, v3;
+    
+    constexpr void round() noexcept {
+        v0 += v1; v2 += v3;
+        v1 = rotl(v1, 13); v3 = rotl(v3, 16);
+        v1 ^= v0; v3 ^= v2;
+        v0 = rotl(v0, 32);
+        v2 += v1; v0 += v3;
+        v1 = rotl(v1, 17); v3 = rotl(v3, 21);
+        v1 ^= v2; v3 ^= v0;
+        v2 = rotl(v2, 32);
+    }
+    
+    constexpr void compress(const std::uint64_t m) noexcept {
+        v3 ^= m;
+        round();
+        round();
+        v0 ^= m;
+    }
+    
+};
+
+template <typename Byte>
+constexpr std::uint64_t siphash24(const key_type &key, const Byte *data, const std::size_t len) noexcept {
+    
+    const std::uint64_t k0 = load_le(key.data(), 8);
+    const std::uint64_t k1 = load_le(key.data() + 8, 8);
+    state s = {
+        k0 ^ 0x736f6d6570736575ULL, k1 ^ 0x646f72616e646f6dULL,
+        k0 ^ 0x6c7967656e657261ULL, k1 ^ 0x7465646279746573ULL
+    };
+    std::size_t i = 0;
+    
+    for (; len - i >= 8; i += 8) s.compress(load_le(data + i, 8));
+    s.compress(load_le(data + i, len - i) | (static_cast<std::uint64_t>(len & 0xff) << 56));
+    
+    s.v2 ^= 0xff;
+    s.round();
+    s.round();
+    s.round();
+    s.round();
+    
+    return s.v0 ^ s.v1 ^ s.v2 ^ s.v3;
+    
+}
+
+inline std::uint64_t hash_value(const std::uint8_t *hash) noexcept {
+    return load_le(hash, 8);
+}
+
+}
+
+/*
+ * SipHash-2-4 evaluated by the compiler whenever the arguments are constant expressions. The hash is
+ * returned as an integer, i.e. the little-endian interpretation of the bytes siphash() stores.
+ */
+constexpr std::uint64_t siphash24(const key_type &key, const std::string_view data) noexcept {
+    return detail::siphash24(key, data.data(), data.size());
+}
+
+#if __cplusplus >= 202002L
+
+constexpr std::uint64_t siphash24(const key_type &key, const std::span<const std::byte> data) noexcept {
+    return detail::siphash24(key, data.data(), data.size());
+}
+
+#endif
+
+/*
+ * Runtime hashing, forwarded to the C implementation. With C++20 the calls made in constant
+ * expressions are evaluated by the constexpr implementation instead.
+ */
+#if __cplusplus >= 202002L
+
+constexpr std::uint64_t siphash(const key_type &key, const std::string_view data) noexcept {
+    std::uint8_t hash[8] = {};
+    if (std::is_constant_evaluated()) return siphash24(key, data);
+    ::siphash(hash, reinterpret_cast<const std::uint8_t *>(data.data()), data.size(), key.data());
+    return detail::hash_value(hash);
+}
+
+constexpr std::uint64_t siphash(const key_type &key, const std::span<const std::byte> data) noexcept {
+    std::uint8_t hash[8] = {};
+    if (std::is_constant_evaluated()) return siphash24(key, data);
+    ::siphash(hash, reinterpret_cast<const std::uint8_t *>(data.data()), data.size(), key.data());
+    return detail::hash_value(hash);
+}
+
+#else
+
+inline std::uint64_t siphash(const key_type &key, const std::string_view data) noexcept {
+    std::uint8_t hash[8];
+    ::siphash(hash, reinterpret_cast<const std::uint8_t *>(data.data()), data.size(), key.data());
+    return detail::hash_value(hash);
+}
+
+#endif
+
+/*
+ * Hash functor holding the prepared key, suitable as the Hash parameter of unordered containers.
+ */
+class hasher {
+    
+    siphash_key_t key_;
+    
+public:
+    
+    explicit hasher(const key_type &key) noexcept {
+        siphash_key_init(&key_, key.data());
+    }
+    
+    std::size_t operator()(const std::string_view data) const noexcept {
+        std::uint8_t hash[8];
+        siphash_with_key(hash, reinterpret_cast<const std::uint8_t *>(data.data()), data.size(), &key_);
+        return static_cast<std::size_t>(detail::hash_value(hash));
+    }
+    
+#if __cplusplus >= 202002L
+    std::size_t operator()(const std::span<const std::byte> data) const noexcept {
+        std::uint8_t hash[8];
+        siphash_with_key(hash, reinterpret_cast<const std::uint8_t *>(data.data()), data.size(), &key_);
+        return static_cast<std::size_t>(detail::hash_value(hash));
+    }
+#endif
+    
+};
+
+}
+
+#endif
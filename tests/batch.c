@@ -0,0 +1,118 @@
+/*
+ * batch.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Test every batch kernel supported by the CPU against siphash()
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "siphash_batch.h"
+#define MAXLEN 100
+#define MAXBATCH 37
+#define ROUNDS 50
+
+static const char *names[] = {"scalar", "sse2", "avx2", "avx512"};
+
+void hexdump(const uint8_t * data, const size_t len) {
+    unsigned int i;
+    for (i = 0; i < len; i++)
+        printf("0x%02x ",data[i]);
+    printf("\n");
+}
+
+/*
+ * Batches of random sizes holding messages of random, mixed lengths.
+ */
+int test_kernel(const int isa) {
+    
+    uint8_t pool[MAXBATCH * MAXLEN], hashes[MAXBATCH * 8], expected[8], k[16];
+    uint8_t lane_keys[MAXBATCH][16], key_hashes[MAXBATCH * 8];
+    const uint8_t *datas[MAXBATCH], *keys[MAXBATCH];
+    size_t lens[MAXBATCH], n, i, j;
+    int round;
+    
+    srand(1);
+    
+    for (i = 0; i < sizeof(pool); i++) pool[i] = (uint8_t) rand();
+    
+    for (round = 0; round < ROUNDS; round++) {
+        
+        for (i = 0; i < 16; i++) k[i] = (uint8_t) rand();
+        
+        n = (size_t) rand() % (MAXBATCH + 1);
+        
+        for (i = 0; i < n; i++) {
+            lens[i] = (size_t) rand() % MAXLEN;
+            datas[i] = pool + (size_t) rand() % (sizeof(pool) - lens[i]);
+            for (j = 0; j < 16; j++) lane_keys[i][j] = (uint8_t) rand();
+            keys[i] = lane_keys[i];
+        }
+        
+        siphash_batch(hashes, datas, lens, n, k);
+        siphash_batch_keys(key_hashes, datas, lens, n, keys);
+        
+        for (i = 0; i < n; i++) {
+            siphash(expected, datas[i], lens[i], k);
+            if (memcmp(hashes + 8 * i, expected, 8)) {
+                printf("%s kernel failed for lane %d of %d, %d bytes\n", names[isa], (int) i,
+                    (int) n, (int) lens[i]);
+                printf("Expected:\t"); hexdump(expected, 8);
+                printf("Got:\t\t"); hexdump(hashes + 8 * i, 8);
+                return 0;
+            }
+            siphash(expected, datas[i], lens[i], keys[i]);
+            if (memcmp(key_hashes + 8 * i, expected, 8)) {
+                printf("%s kernel failed for lane %d of %d with per-lane keys, %d bytes\n", names[isa],
+                    (int) i, (int) n, (int) lens[i]);
+                printf("Expected:\t"); hexdump(expected, 8);
+                printf("Got:\t\t"); hexdump(key_hashes + 8 * i, 8);
+                return 0;
+            }
+        }
+        
+    }
+    
+    return 1;
+    
+}
+
+int main() {
+    
+    int isa, ok = 1;
+    
+    for (isa = SIPHASH_BATCH_SCALAR; isa <= SIPHASH_BATCH_AVX512; isa++) {
+        if (siphash_batch_select(isa) < 0) {
+            printf("batch %s kernel not supported, skipped\n", names[isa]);
+            continue;
+        }
+        if (test_kernel(isa)) printf("batch %s kernel ok (%d-bit backend)\n", names[isa], MSH_BACKEND);
+        else ok = 0;
+    }
+    
+    return !ok;
+    
+}
@@ -0,0 +1,252 @@
+/*
+ * hashmap.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Test the hash map, including its behaviour under adversarial input crafted to collide under
+ * a non-keyed hash
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include "hashmap.h"
+
+#define KEYS 20000
+#define KEY_LEN 8
+#define ATTACK_KEYS 2000
+#define ATTACK_CAPACITY 4096
+
+static uint8_t keys[KEYS][KEY_LEN];
+
+/* Deterministic random source, so the test is reproducible. */
+static int test_random(uint8_t *buf, const size_t len) {
+    size_t i;
+    for (i = 0; i < len; i++) buf[i] = (uint8_t) rand();
+    return 0;
+}
+
+/* Non-keyed FNV-1a, as commonly used by hash tables. */
+static uint32_t fnv1a(const uint8_t *data, const size_t len) {
+    uint32_t h = 2166136261UL;
+    size_t i;
+    for (i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+static void fnv1a_hash(uint8_t *hash, const uint8_t *data, const size_t len, const siphash_key_t *key) {
+    uint32_t h = fnv1a(data, len);
+    (void) key;
+    hash[0] = (uint8_t) h;
+    hash[1] = (uint8_t) (h >> 8);
+    hash[2] = (uint8_t) (h >> 16);
+    hash[3] = (uint8_t) (h >> 24);
+    hash[4] = (uint8_t) (h >> 25);
+}
+
+/* Source handing out the all-zero key first, as if it had leaked. */
+static int leaked_calls = 0;
+static int leaked_random(uint8_t *buf, const size_t len) {
+    if (leaked_calls++ == 0) {
+        memset(buf, 0, len);
+        return 0;
+    }
+    return test_random(buf, len);
+}
+
+/* SipHash which collides everything under the leaked key. */
+static void leaked_hash(uint8_t *hash, const uint8_t *data, const size_t len, const siphash_key_t *key) {
+    siphash_key_t leaked;
+    uint8_t zero[16];
+    memset(zero, 0, sizeof(zero));
+    siphash_key_init(&leaked, zero);
+    if (!memcmp(key, &leaked, sizeof(leaked))) memset(hash, 0, 8);
+    else siphash_with_key(hash, data, len, key);
+}
+
+static int check_all(msh_map *map, const size_t n) {
+    size_t i;
+    msh_map_slot *slot;
+    for (i = 0; i < n; i++) {
+        slot = msh_map_find(map, keys[i], KEY_LEN);
+        if (!slot || slot->value != (void *) keys[i]) return 0;
+    }
+    return 1;
+}
+
+int test_basic() {
+    
+    msh_map map;
+    size_t i;
+    int ok = 1;
+    
+    if (msh_map_init(&map, 0, test_random)) return 0;
+    
+    for (i = 0; i < KEYS; i++) {
+        if (msh_map_insert(&map, keys[i], KEY_LEN, (void *) keys[i]) != 0) {
+            printf("insert failed for key %d\n", (int) i);
+            ok = 0;
+        }
+    }
+    
+    if (map.size != KEYS || !check_all(&map, KEYS)) {
+        printf("lookup after growth failed\n");
+        ok = 0;
+    }
+    
+    for (i = 0; i < KEYS; i += 2) msh_map_remove(&map, keys[i], KEY_LEN);
+    
+    for (i = 0; i < KEYS; i++) {
+        if ((msh_map_find(&map, keys[i], KEY_LEN) != NULL) != (int) (i & 1)) {
+            printf("lookup after removal failed for key %d\n", (int) i);
+            ok = 0;
+            break;
+        }
+    }
+    
+    /* Reinsert over the tombstones, replace the remaining ones. */
+    for (i = 0; i < KEYS; i++) {
+        if (msh_map_insert(&map, keys[i], KEY_LEN, (void *) keys[i]) != (int) (i & 1)) {
+            printf("reinsert failed for key %d\n", (int) i);
+            ok = 0;
+            break;
+        }
+    }
+    
+    if (msh_map_rekey(&map) || map.size != KEYS || !check_all(&map, KEYS)) {
+        printf("lookup after rekey failed\n");
+        ok = 0;
+    }
+    
+    /* Capacities whose table can't be addressed are refused, the map stays usable. */
+    if (msh_map_rehash(&map, (size_t) -1) != -2 || map.size != KEYS || !check_all(&map, KEYS)) {
+        printf("oversized rehash failed\n");
+        ok = 0;
+    }
+    
+    msh_map_free(&map);
+    
+    return ok;
+    
+}
+
+/*
+ * The attacker knows the hash function, so for the non-keyed one they can find keys falling into
+ * the same group of a table of the expected size. Under SipHash with a random key these keys shall
+ * be spread evenly.
+ */
+int test_attack() {
+    
+    msh_map sip, fnv;
+    size_t found = 0, groups, i;
+    int ok = 1;
+    
+    /* Groups of the table initialized for ATTACK_CAPACITY entries. */
+    if (msh_map_init(&fnv, ATTACK_CAPACITY, test_random)) return 0;
+    fnv.hash = fnv1a_hash;
+    groups = fnv.capacity / MSH_MAP_GROUP;
+    
+    while (found < ATTACK_KEYS) {
+        test_random(keys[found], KEY_LEN);
+        if ((fnv1a(keys[found], KEY_LEN) & (groups - 1)) == 0) found++;
+    }
+    
+    if (msh_map_init(&sip, ATTACK_CAPACITY, test_random)) return 0;
+    
+    for (i = 0; i < ATTACK_KEYS; i++) {
+        msh_map_insert(&sip, keys[i], KEY_LEN, (void *) keys[i]);
+        msh_map_insert(&fnv, keys[i], KEY_LEN, (void *) keys[i]);
+    }
+    
+    if (sip.max_probe > MSH_MAP_MAX_PROBE || sip.rekeys) {
+        printf("probe length under SipHash not bounded\n");
+        ok = 0;
+    }
+    
+    if (!fnv.rekeys || fnv.max_probe <= MSH_MAP_MAX_PROBE) {
+        printf("attack on non-keyed hash not detected\n");
+        ok = 0;
+    }
+    
+    if (!check_all(&sip, ATTACK_KEYS) || !check_all(&fnv, ATTACK_KEYS)) {
+        printf("lookup under attack failed\n");
+        ok = 0;
+    }
+    
+    if (!ok) {
+        printf("adversarial input: siphash max probe %d groups, %lu rekeys; fnv1a max probe %d groups, "
+            "%lu rekeys\n", (int) sip.max_probe, sip.rekeys, (int) fnv.max_probe, fnv.rekeys);
+    }
+    
+    msh_map_free(&sip);
+    msh_map_free(&fnv);
+    
+    return ok;
+    
+}
+
+/*
+ * Once the key leaks, the keys collide until the table rekeys itself.
+ */
+int test_leaked_key() {
+    
+    msh_map map;
+    size_t i;
+    int ok = 1;
+    
+    if (msh_map_init(&map, ATTACK_CAPACITY, leaked_random)) return 0;
+    map.hash = leaked_hash;
+    
+    for (i = 0; i < ATTACK_KEYS; i++) msh_map_insert(&map, keys[i], KEY_LEN, (void *) keys[i]);
+    
+    if (map.rekeys != 1 || map.max_probe > MSH_MAP_MAX_PROBE || !check_all(&map, ATTACK_KEYS)) {
+        printf("rekey after key leak failed: %lu rekeys, max probe %d groups\n", map.rekeys,
+            (int) map.max_probe);
+        ok = 0;
+    }
+    
+    msh_map_free(&map);
+    
+    return ok;
+    
+}
+
+int main() {
+    
+    size_t i;
+    int ok;
+    
+    srand(1);
+    for (i = 0; i < KEYS; i++) test_random(keys[i], KEY_LEN);
+    
+    ok = test_basic();
+    ok &= test_attack();
+    ok &= test_leaked_key();
+    if (ok) printf("hash map ok (%d-bit backend)\n", MSH_BACKEND);
+    
+    return !ok;
+    
+}
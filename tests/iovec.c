@@ -0,0 +1,137 @@
+/*
+ * iovec.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Test the scatter-gather siphash_v() against the one-shot siphash() of the flattened buffer
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "siphash.h"
+#define MAXLEN 600
+#define SPLITS 20
+#define MAXSEGS 64
+
+void hexdump(const uint8_t * data, const size_t len) {
+    unsigned int i;
+    for (i = 0; i < len; i++)
+        printf("0x%02x ",data[i]);
+    printf("\n");
+}
+
+/*
+ * Cut the message into segments of random lengths, including empty ones, and copy each to a
+ * separate, randomly misaligned buffer so no segment is contiguous with the next.
+ */
+int segment(struct iovec *iov, uint8_t *scratch, const uint8_t *data, const size_t len) {
+    
+    size_t offset = 0, chunk;
+    int n = 0;
+    uint8_t *p = scratch;
+    
+    while (n < MAXSEGS - 1 && (offset < len || rand() % 4 == 0)) {
+        chunk = (size_t) rand() % 20;
+        if (rand() % 8 == 0) chunk += (size_t) rand() % 100;
+        if (chunk > len - offset) chunk = len - offset;
+        p += 1 + rand() % 8;
+        memcpy(p, data + offset, chunk);
+        iov[n].iov_base = p;
+        iov[n].iov_len = chunk;
+        p += chunk;
+        offset += chunk;
+        n++;
+    }
+    
+    /* Whatever remains once the segment budget runs out goes into the last one. */
+    p += 1 + rand() % 8;
+    memcpy(p, data + offset, len - offset);
+    iov[n].iov_base = p;
+    iov[n].iov_len = len - offset;
+    
+    return n + 1;
+    
+}
+
+int test_segmentations() {
+    
+    static uint8_t scratch[MAXLEN + 10 * MAXSEGS];
+    uint8_t in[MAXLEN], expected[8], out[8], k[16];
+    struct iovec iov[MAXSEGS];
+    siphash_key_t key;
+    int i, j, n;
+    int ok = 1;
+    
+    srand(1);
+    
+    for (i = 0; i < 16; i++) k[i] = (uint8_t) rand();
+    for (i = 0; i < MAXLEN; i++) in[i] = (uint8_t) rand();
+    
+    siphash_key_init(&key, k);
+    
+    /* No segments at all is the empty message. */
+    siphash(expected, in, 0, k);
+    siphash_v(out, iov, 0, k);
+    if (memcmp(out, expected, 8)) {
+        printf("siphash_v failed for no segments\n");
+        ok = 0;
+    }
+    
+    for (i = 0; i < MAXLEN; i++) {
+        
+        siphash(expected, in, (size_t) i, k);
+        
+        for (j = 0; j < SPLITS; j++) {
+            
+            n = segment(iov, scratch, in, (size_t) i);
+            
+            if (j % 2) siphash_v_with_key(out, iov, n, &key);
+            else siphash_v(out, iov, n, k);
+            
+            if (memcmp(out, expected, 8)) {
+                printf("siphash_v failed for %d bytes in %d segments\n", i, n);
+                printf("Expected:\t"); hexdump(expected, 8);
+                printf("Got:\t\t"); hexdump(out, 8);
+                ok = 0;
+                break;
+            }
+            
+        }
+        
+    }
+    
+    return ok;
+    
+}
+
+int main() {
+    
+    int ok = test_segmentations();
+    if (ok) printf("iovec ok (%d-bit backend)\n", MSH_BACKEND);
+    
+    return !ok;
+    
+}
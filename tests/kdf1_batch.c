@@ -0,0 +1,112 @@
+/*
+ * kdf1_batch.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Test the batched kdf1 of extras/fkdf1 against single derivations, with every batch kernel,
+ * serially and on a thread pool
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include "fkdf1.h"
+#include "siphash_batch.h"
+
+#define N 1000
+#define THREADS 4
+
+static const char *names[] = {"scalar", "sse2", "avx2", "avx512"};
+static const size_t lengths[] = {0, 1, 8, 13, 64, 1023};
+
+static uint8_t key_pool[N][16], info_pool[N][KDF_INFO_LEN], scratch[KDF_BATCH_SCRATCH(N)];
+static uint8_t derived[N * 1023], expected[1023];
+static const uint8_t *keys[N], *infos[N];
+static size_t info_lens[N];
+
+static int check(const char *mode, const int isa, const size_t len) {
+    
+    size_t i;
+    
+    for (i = 0; i < N; i++) {
+        kdf1(expected, len, infos[i], info_lens[i], keys[i]);
+        if (memcmp(derived + i * len, expected, len)) {
+            printf("%s %s batch failed for derivation %d, %d bytes\n", mode, names[isa], (int) i,
+                (int) len);
+            return 0;
+        }
+    }
+    
+    return 1;
+    
+}
+
+int main() {
+    
+    msh_pool pool;
+    size_t i, j, l;
+    int isa, ok = 1;
+    
+    srand(1);
+    
+    for (i = 0; i < N; i++) {
+        for (j = 0; j < 16; j++) key_pool[i][j] = (uint8_t) rand();
+        for (j = 0; j < KDF_INFO_LEN; j++) info_pool[i][j] = (uint8_t) rand();
+        keys[i] = key_pool[i];
+        infos[i] = info_pool[i];
+        info_lens[i] = (size_t) rand() % (KDF_INFO_LEN + 1);
+    }
+    
+    if (msh_pool_init(&pool, THREADS)) return 1;
+    
+    for (isa = SIPHASH_BATCH_SCALAR; isa <= SIPHASH_BATCH_AVX512; isa++) {
+        
+        if (siphash_batch_select(isa) < 0) continue;
+        
+        for (l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            
+            if (kdf1_batch(derived, lengths[l], infos, info_lens, keys, N, scratch)) ok = 0;
+            ok &= check("serial", isa, lengths[l]);
+            
+            memset(derived, 0, sizeof(derived));
+            if (kdf1_batch_parallel(derived, lengths[l], infos, info_lens, keys, N, scratch, &pool)) {
+                ok = 0;
+            }
+            ok &= check("parallel", isa, lengths[l]);
+            
+        }
+        
+    }
+    
+    if (!kdf1_batch(derived, 1024, infos, info_lens, keys, N, scratch)) {
+        printf("derived key length limit not enforced\n");
+        ok = 0;
+    }
+    
+    msh_pool_free(&pool);
+    
+    if (ok) printf("kdf1 batch ok (%d-bit backend)\n", MSH_BACKEND);
+    
+    return !ok;
+    
+}
@@ -0,0 +1,241 @@
+/*
+ * keystore.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Test the key rotation store: readers hashing under a writer rotating the key as fast as it can,
+ * and reclamation being held off by a pinned key set
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "keystore.h"
+
+#define READERS 8
+#define ROTATIONS 20000
+#define MSG_LEN 24
+
+static msh_keystore store;
+static int done, failed;
+static unsigned long reads[READERS];
+
+/* The raw key of the period v is all bytes v, so a reader can check the set is consistent. */
+static void key_of(uint8_t *key, const unsigned long version) {
+    memset(key, (uint8_t) version, 16);
+}
+
+static int check_keyset(const msh_keyset *keys, const unsigned long last) {
+    
+    uint8_t key[16], msg[MSG_LEN], a[8], b[8];
+    
+    /* A wiped set reads as version 0. */
+    if (keys->version < 1 || keys->version < last) return 0;
+    
+    key_of(key, keys->version);
+    if (memcmp(key, keys->current_raw, 16)) return 0;
+    key_of(key, keys->version > 1 ? keys->version - 1 : 1);
+    if (memcmp(key, keys->previous_raw, 16)) return 0;
+    
+    memset(msg, (uint8_t) last, sizeof(msg));
+    siphash(a, msg, sizeof(msg), keys->current_raw);
+    siphash_with_key(b, msg, sizeof(msg), &keys->current);
+    if (memcmp(a, b, 8)) return 0;
+    siphash(a, msg, sizeof(msg), keys->previous_raw);
+    siphash_with_key(b, msg, sizeof(msg), &keys->previous);
+    if (memcmp(a, b, 8)) return 0;
+    
+    return 1;
+    
+}
+
+static void *reader(void *arg) {
+    
+    int id = *(int *) arg;
+    msh_keystore_reader *r = msh_keystore_register(&store);
+    const msh_keyset *keys;
+    unsigned long last = 1;
+    
+    if (!r) {
+        printf("keystore: reader %d not registered\n", id);
+        __atomic_store_n(&failed, 1, __ATOMIC_SEQ_CST);
+        return NULL;
+    }
+    
+    while (!__atomic_load_n(&done, __ATOMIC_SEQ_CST)) {
+        keys = msh_keystore_enter(&store, r);
+        if (!check_keyset(keys, last)) {
+            printf("keystore: reader %d got an inconsistent key set after version %lu\n", id, last);
+            __atomic_store_n(&failed, 1, __ATOMIC_SEQ_CST);
+            msh_keystore_exit(r);
+            break;
+        }
+        last = keys->version;
+        msh_keystore_exit(r);
+        reads[id]++;
+    }
+    
+    msh_keystore_unregister(r);
+    
+    return NULL;
+    
+}
+
+int test_stress(void) {
+    
+    pthread_t threads[READERS];
+    int ids[READERS], i, started = 0, ok = 1;
+    unsigned long v;
+    uint8_t key[16];
+    
+    key_of(key, 1);
+    if (msh_keystore_init(&store, key)) return 0;
+    
+    for (i = 0; i < READERS; i++) {
+        ids[i] = i;
+        if (pthread_create(&threads[i], NULL, reader, &ids[i])) break;
+        started++;
+    }
+    
+    for (v = 2; v <= ROTATIONS + 1; v++) {
+        key_of(key, v);
+        if (msh_keystore_rotate(&store, key)) {
+            printf("keystore: rotation failed\n");
+            ok = 0;
+            break;
+        }
+    }
+    
+    __atomic_store_n(&done, 1, __ATOMIC_SEQ_CST);
+    for (i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    
+    if (failed || started < READERS) ok = 0;
+    if (store.keys->version != ROTATIONS + 1) {
+        printf("keystore: version %lu after %d rotations\n", store.keys->version, ROTATIONS);
+        ok = 0;
+    }
+    if (msh_keystore_reclaim(&store)) {
+        printf("keystore: key sets left with no readers\n");
+        ok = 0;
+    }
+    
+    msh_keystore_free(&store);
+    
+    return ok;
+    
+}
+
+/*
+ * A set pinned by a reader survives any number of rotations, and is reclaimed after the read.
+ */
+int test_pinned(void) {
+    
+    msh_keystore_reader *r;
+    const msh_keyset *keys;
+    uint8_t key[16];
+    int ok = 1;
+    unsigned long v;
+    
+    key_of(key, 1);
+    if (msh_keystore_init(&store, key)) return 0;
+    
+    r = msh_keystore_register(&store);
+    if (!r) return 0;
+    
+    keys = msh_keystore_enter(&store, r);
+    for (v = 2; v <= 4; v++) {
+        key_of(key, v);
+        msh_keystore_rotate(&store, key);
+    }
+    
+    if (!check_keyset(keys, 1) || keys->version != 1) {
+        printf("keystore: pinned key set reclaimed\n");
+        ok = 0;
+    }
+    if (msh_keystore_reclaim(&store) != 3) {
+        printf("keystore: retired key sets reclaimed under a reader\n");
+        ok = 0;
+    }
+    
+    msh_keystore_exit(r);
+    if (msh_keystore_reclaim(&store)) {
+        printf("keystore: retired key sets not reclaimed\n");
+        ok = 0;
+    }
+    
+    keys = msh_keystore_enter(&store, r);
+    if (!check_keyset(keys, 4) || keys->version != 4) ok = 0;
+    msh_keystore_exit(r);
+    
+    msh_keystore_unregister(r);
+    msh_keystore_free(&store);
+    
+    return ok;
+    
+}
+
+/*
+ * All the reader slots can be taken, and reused once released. Each one starts a cache line.
+ */
+int test_register(void) {
+    
+    msh_keystore_reader *r[MSH_KEYSTORE_READERS];
+    uint8_t key[16];
+    int i, ok = 1;
+    
+    key_of(key, 1);
+    if (msh_keystore_init(&store, key)) return 0;
+    
+    for (i = 0; i < MSH_KEYSTORE_READERS; i++) {
+        if (!(r[i] = msh_keystore_register(&store))) ok = 0;
+        else if ((uintptr_t) r[i] % MSH_KEYSTORE_LINE) ok = 0;
+    }
+    if (msh_keystore_register(&store)) ok = 0;
+    msh_keystore_unregister(r[5]);
+    if (msh_keystore_register(&store) != r[5]) ok = 0;
+    if (!ok) printf("keystore: reader registration failed\n");
+    
+    for (i = 0; i < MSH_KEYSTORE_READERS; i++) msh_keystore_unregister(r[i]);
+    msh_keystore_free(&store);
+    
+    return ok;
+    
+}
+
+int main() {
+    
+    int ok = 1;
+    
+    ok &= test_register();
+    ok &= test_pinned();
+    ok &= test_stress();
+    
+    if (ok) printf("keystore ok (%d-bit backend)\n", MSH_BACKEND);
+    
+    return !ok;
+    
+}
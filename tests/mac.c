@@ -0,0 +1,246 @@
+/*
+ * mac.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Test the batched packet authentication on a ring of packets, and end to end over loopback UDP
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "mac.h"
+
+#define RING 37
+#define HEAD 20
+#define PACKETS 256
+#define BURST 32
+#define MAX_FRAME 1400
+
+static uint8_t frames[PACKETS][MAX_FRAME], received[PACKETS][MAX_FRAME];
+static size_t frame_lens[PACKETS];
+static siphash_mac_desc ring[PACKETS];
+static uint8_t bitmap[(PACKETS + 7) / 8 + 1];
+
+/* Packets i with i % TAMPER == 0 are altered after signing, alternately in the payload and the tag. */
+#define TAMPER 5
+
+static void tamper(siphash_mac_desc *d, const size_t i) {
+    if ((i / TAMPER) % 2 && d->len) d->data[i % d->len] ^= 0x01;
+    else d->data[d->tag_off + i % SIPHASH_MAC_TAG] ^= 0x80;
+}
+
+/*
+ * Check the bitmap of n packets, packet i having been tampered with if tampered is set.
+ */
+static int check_bitmap(const char *name, const size_t n, const size_t passed, const int tampered) {
+    
+    size_t i, expected_passed = 0;
+    int bit, expected;
+    
+    for (i = 0; i < n; i++) {
+        bit = (bitmap[i / 8] >> (i % 8)) & 1;
+        expected = !(tampered && i % TAMPER == 0);
+        expected_passed += (size_t) expected;
+        if (bit != expected) {
+            printf("%s: packet %lu %s\n", name, (unsigned long) i, bit ? "passed" : "failed");
+            return 0;
+        }
+    }
+    
+    /* Bits past the last packet stay clear. */
+    for (; i % 8; i++) {
+        if ((bitmap[i / 8] >> (i % 8)) & 1) {
+            printf("%s: bit %lu past the end set\n", name, (unsigned long) i);
+            return 0;
+        }
+    }
+    
+    if (passed != expected_passed) {
+        printf("%s: %lu packets passed, %lu expected\n", name, (unsigned long) passed,
+            (unsigned long) expected_passed);
+        return 0;
+    }
+    
+    return 1;
+    
+}
+
+int test_equal() {
+    
+    uint8_t a[SIPHASH_MAC_TAG], b[SIPHASH_MAC_TAG];
+    int i, ok = 1;
+    
+    for (i = 0; i < SIPHASH_MAC_TAG; i++) a[i] = b[i] = (uint8_t) rand();
+    if (!siphash_mac_equal(a, b)) ok = 0;
+    
+    for (i = 0; i < 8 * SIPHASH_MAC_TAG; i++) {
+        b[i / 8] ^= (uint8_t) (1 << (i % 8));
+        if (siphash_mac_equal(a, b)) ok = 0;
+        b[i / 8] ^= (uint8_t) (1 << (i % 8));
+    }
+    
+    if (!ok) printf("siphash_mac_equal failed\n");
+    
+    return ok;
+    
+}
+
+int test_ring(const uint8_t *key) {
+    
+    uint8_t expected[8];
+    size_t i, passed;
+    int ok = 1;
+    
+    /* Random lengths with a trailing tag, the ring wrapping around in the middle of the batch. */
+    for (i = 0; i < RING; i++) {
+        frame_lens[i] = (size_t) rand() % 300;
+        ring[i].data = frames[i];
+        ring[i].len = frame_lens[i];
+        ring[i].tag_off = frame_lens[i];
+    }
+    
+    siphash_mac_sign_batch(ring, RING, HEAD, RING, key);
+    
+    for (i = 0; i < RING; i++) {
+        siphash(expected, ring[i].data, ring[i].len, key);
+        if (memcmp(expected, ring[i].data + ring[i].tag_off, 8)) {
+            printf("ring: wrong tag of packet %lu\n", (unsigned long) i);
+            ok = 0;
+        }
+    }
+    
+    passed = siphash_mac_verify_batch(ring, RING, HEAD, RING, key, bitmap);
+    ok &= check_bitmap("ring", RING, passed, 0);
+    
+    for (i = 0; i < RING; i += TAMPER) tamper(&ring[(HEAD + i) % RING], i);
+    passed = siphash_mac_verify_batch(ring, RING, HEAD, RING, key, bitmap);
+    ok &= check_bitmap("ring tampered", RING, passed, 1);
+    
+    return ok;
+    
+}
+
+/*
+ * Sign the packets, send them over loopback UDP in bursts, some of them altered on the way, and
+ * verify what is received.
+ */
+int test_udp(const uint8_t *key) {
+    
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    struct timeval timeout;
+    ssize_t got;
+    size_t i, j, passed;
+    int rx, tx, ok = 1;
+    
+    rx = socket(AF_INET, SOCK_DGRAM, 0);
+    tx = socket(AF_INET, SOCK_DGRAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    
+    if (rx < 0 || tx < 0 || bind(rx, (struct sockaddr *) &addr, sizeof(addr)) ||
+        getsockname(rx, (struct sockaddr *) &addr, &addr_len)) {
+        printf("mac: loopback UDP not available, skipped\n");
+        if (rx >= 0) close(rx);
+        if (tx >= 0) close(tx);
+        return 1;
+    }
+    
+    timeout.tv_sec = 1;
+    timeout.tv_usec = 0;
+    setsockopt(rx, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    
+    for (i = 0; i < PACKETS; i++) {
+        frame_lens[i] = SIPHASH_MAC_TAG + (size_t) rand() % (MAX_FRAME - SIPHASH_MAC_TAG);
+        for (j = 0; j < frame_lens[i]; j++) frames[i][j] = (uint8_t) rand();
+        ring[i].data = frames[i];
+        ring[i].len = frame_lens[i] - SIPHASH_MAC_TAG;
+        ring[i].tag_off = ring[i].len;
+    }
+    
+    siphash_mac_sign_batch(ring, PACKETS, 0, PACKETS, key);
+    for (i = 0; i < PACKETS; i += TAMPER) tamper(&ring[i], i);
+    
+    for (i = 0; i < PACKETS && ok; i++) {
+        
+        if (sendto(tx, frames[i], frame_lens[i], 0, (struct sockaddr *) &addr, sizeof(addr)) !=
+            (ssize_t) frame_lens[i]) {
+            printf("udp: send failed\n");
+            ok = 0;
+        }
+        
+        /* Drain every burst, so the socket buffer can't overflow. */
+        if (i % BURST == BURST - 1 || i == PACKETS - 1) {
+            for (j = i - i % BURST; j <= i && ok; j++) {
+                got = recv(rx, received[j], MAX_FRAME, 0);
+                if (got != (ssize_t) frame_lens[j]) {
+                    printf("udp: packet %lu lost\n", (unsigned long) j);
+                    ok = 0;
+                }
+                ring[j].data = received[j];
+                ring[j].len = (size_t) got - SIPHASH_MAC_TAG;
+                ring[j].tag_off = ring[j].len;
+            }
+        }
+        
+    }
+    
+    if (ok) {
+        passed = siphash_mac_verify_batch(ring, PACKETS, 0, PACKETS, key, bitmap);
+        ok = check_bitmap("udp", PACKETS, passed, 1);
+    }
+    
+    close(rx);
+    close(tx);
+    
+    return ok;
+    
+}
+
+int main() {
+    
+    uint8_t key[16];
+    int i, ok;
+    
+    srand(1);
+    for (i = 0; i < 16; i++) key[i] = (uint8_t) rand();
+    
+    ok = test_equal();
+    ok &= test_ring(key);
+    ok &= test_udp(key);
+    if (ok) printf("mac ok (%d-bit backend)\n", MSH_BACKEND);
+    
+    return !ok;
+    
+}
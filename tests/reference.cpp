@@ -0,0 +1,130 @@
+/*
+ * reference.cpp
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Test the C++ wrapper. The constexpr implementation is checked against reference test vectors at
+ * compile time, the runtime overloads and the functor against it at runtime.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include "siphash.hpp"
+#include "vectors.h"
+
+constexpr msh::key_type key = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+
+constexpr std::array<char, 64> make_input() {
+    std::array<char, 64> in = {};
+    for (std::size_t i = 0; i < in.size(); i++) in[i] = static_cast<char>(i);
+    return in;
+}
+
+constexpr std::array<char, 64> in = make_input();
+
+constexpr bool test_vectors() {
+    for (std::size_t i = 0; i < in.size(); i++) {
+        if (msh::siphash24(key, std::string_view(in.data(), i)) != msh::detail::load_le(vectors[i], 8)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(test_vectors(), "constexpr SipHash-2-4 doesn't match the test vectors");
+
+#if __cplusplus >= 202002L
+
+constexpr bool test_vectors_span() {
+    std::array<std::byte, 64> bytes = {};
+    for (std::size_t i = 0; i < bytes.size(); i++) bytes[i] = static_cast<std::byte>(i);
+    for (std::size_t i = 0; i < bytes.size(); i++) {
+        if (msh::siphash(key, std::span<const std::byte>(bytes.data(), i)) != msh::detail::load_le(vectors[i], 8)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(test_vectors_span(), "constexpr SipHash-2-4 over std::span doesn't match the test vectors");
+
+#endif
+
+/* Hash of a string literal usable as a switch label. */
+constexpr std::uint64_t hello = msh::siphash24(key, "Hello world!");
+
+int test_runtime() {
+    
+    std::string data;
+    msh::hasher hasher(key);
+    std::unordered_map<std::string, int, msh::hasher> map(16, hasher);
+    int i, ok = 1;
+    
+    std::srand(1);
+    
+    for (i = 0; i < 300; i++) {
+        
+        if (msh::siphash(key, data) != msh::siphash24(key, data)) {
+            std::printf("runtime hash differs from constexpr one for %d bytes\n", i);
+            ok = 0;
+        }
+        
+        if (hasher(data) != static_cast<std::size_t>(msh::siphash24(key, data))) {
+            std::printf("functor hash differs from constexpr one for %d bytes\n", i);
+            ok = 0;
+        }
+        
+        map[data] = i;
+        data.push_back(static_cast<char>(std::rand()));
+        
+    }
+    
+    switch (msh::siphash(key, "Hello world!")) {
+        case hello:
+            break;
+        default:
+            std::printf("switch on string literal hash failed\n");
+            ok = 0;
+    }
+    
+    if (map.size() != 300) {
+        std::printf("unordered_map lost some keys\n");
+        ok = 0;
+    }
+    
+    return ok;
+    
+}
+
+int main() {
+    
+    int ok = test_runtime();
+    if (ok) std::printf("C++ wrapper ok (C++%ld, %d-bit backend)\n", __cplusplus / 100 % 100, MSH_BACKEND);
+    
+    return !ok;
+    
+}
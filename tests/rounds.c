@@ -0,0 +1,243 @@
+/*
+ * rounds.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Test SipHash-1-3 and SipHash-4-8 variants against test vectors
+ * 
+ * Test vectors were generated with an independent SipHash-c-d implementation, which reproduces the
+ * SipHash-2-4 vectors of tests/reference.c
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include "siphash.h"
+#define MAXLEN 64
+
+typedef void (*hash_fn)(uint8_t *, const uint8_t *, const size_t, const uint8_t *);
+typedef void (*hash_with_key_fn)(uint8_t *, const uint8_t *, const size_t, const siphash_key_t *);
+
+/*
+   SipHash-1-3 output with
+   k = 00 01 02 ...
+   and
+   in = (empty string)
+   in = 00 (1 byte)
+   in = 00 01 (2 bytes)
+   in = 00 01 02 (3 bytes)
+   ...
+   in = 00 01 02 ... 3e (63 bytes)
+*/
+uint8_t vectors13[64][8] =
+{
+    { 0xdc, 0xc4, 0x0f, 0x05, 0x58, 0x01, 0xac, 0xab, },
+    { 0x93, 0xca, 0x57, 0x7d, 0xf3, 0x9b, 0xf4, 0xc9, },
+    { 0x4d, 0xd4, 0xc7, 0x4d, 0x02, 0x9b, 0xcb, 0x82, },
+    { 0xfb, 0xf7, 0xdd, 0xe7, 0xb8, 0x0a, 0xf8, 0x8b, },
+    { 0x28, 0x83, 0xd3, 0x88, 0x60, 0x57, 0x75, 0xcf, },
+    { 0x67, 0x3b, 0x53, 0x49, 0x2f, 0xd5, 0xf9, 0xde, },
+    { 0xa7, 0x22, 0x9f, 0xc5, 0x50, 0x2b, 0x0d, 0xc5, },
+    { 0x40, 0x11, 0xb1, 0x9b, 0x98, 0x7d, 0x92, 0xd3, },
+    { 0x8e, 0x9a, 0x29, 0x8d, 0x11, 0x95, 0x90, 0x36, },
+    { 0xe4, 0x3d, 0x06, 0x6c, 0xb3, 0x8e, 0xa4, 0x25, },
+    { 0x7f, 0x09, 0xff, 0x92, 0xee, 0x85, 0xde, 0x79, },
+    { 0x52, 0xc3, 0x4d, 0xf9, 0xc1, 0x18, 0xc1, 0x70, },
+    { 0xa2, 0xd9, 0xb4, 0x57, 0xb1, 0x84, 0xa3, 0x78, },
+    { 0xa7, 0xff, 0x29, 0x12, 0x0c, 0x76, 0x6f, 0x30, },
+    { 0x34, 0x5d, 0xf9, 0xc0, 0x11, 0xa1, 0x5a, 0x60, },
+    { 0x56, 0x99, 0x51, 0x2a, 0x6d, 0xd8, 0x20, 0xd3, },
+    { 0x66, 0x8b, 0x90, 0x7d, 0x1a, 0xdd, 0x4f, 0xcc, },
+    { 0x0c, 0xd8, 0xdb, 0x63, 0x90, 0x68, 0xf2, 0x9c, },
+    { 0x3e, 0xe6, 0x73, 0xb4, 0x9c, 0x38, 0xfc, 0x8f, },
+    { 0x1c, 0x7d, 0x29, 0x8d, 0xe5, 0x9d, 0x1f, 0xf2, },
+    { 0x40, 0xe0, 0xcc, 0xa6, 0x46, 0x2f, 0xdc, 0xc0, },
+    { 0x44, 0xf8, 0x45, 0x2b, 0xfe, 0xab, 0x92, 0xb9, },
+    { 0x2e, 0x87, 0x20, 0xa3, 0x9b, 0x7b, 0xfe, 0x7f, },
+    { 0x23, 0xc1, 0xe6, 0xda, 0x7f, 0x0e, 0x5a, 0x52, },
+    { 0x8c, 0x9c, 0x34, 0x67, 0xb2, 0xae, 0x64, 0xf4, },
+    { 0x79, 0x09, 0x5b, 0x70, 0x28, 0x59, 0xcd, 0x45, },
+    { 0xa5, 0x13, 0x99, 0xca, 0xe3, 0x35, 0x3e, 0x3a, },
+    { 0x35, 0x3b, 0xde, 0x4a, 0x4e, 0xc7, 0x1d, 0xa9, },
+    { 0x0d, 0xd0, 0x6c, 0xef, 0x02, 0xed, 0x0b, 0xfb, },
+    { 0xf4, 0xe1, 0xb1, 0x4a, 0xb4, 0x3c, 0xd9, 0x88, },
+    { 0x63, 0xe6, 0xc5, 0x43, 0xd6, 0x11, 0x0f, 0x54, },
+    { 0xbc, 0xd1, 0x21, 0x8c, 0x1f, 0xdd, 0x70, 0x23, },
+    { 0x0d, 0xb6, 0xa7, 0x16, 0x6c, 0x7b, 0x15, 0x81, },
+    { 0xbf, 0xf9, 0x8f, 0x7a, 0xe5, 0xb9, 0x54, 0x4d, },
+    { 0x3e, 0x75, 0x2a, 0x1f, 0x78, 0x12, 0x9f, 0x75, },
+    { 0x91, 0x6b, 0x18, 0xbf, 0xbe, 0xa3, 0xa1, 0xce, },
+    { 0x06, 0x62, 0xa2, 0xad, 0xd3, 0x08, 0xf5, 0x2c, },
+    { 0x57, 0x30, 0xc3, 0xa3, 0x2d, 0x1c, 0x10, 0xb6, },
+    { 0xa1, 0x36, 0x3a, 0xae, 0x96, 0x74, 0xf4, 0xb3, },
+    { 0x92, 0x83, 0x10, 0x7b, 0x54, 0x57, 0x6b, 0x62, },
+    { 0x31, 0x15, 0xe4, 0x99, 0x32, 0x36, 0xd2, 0xc1, },
+    { 0x44, 0xd9, 0x1a, 0x3f, 0x92, 0xc1, 0x7c, 0x66, },
+    { 0x25, 0x88, 0x13, 0xc8, 0xfe, 0x4f, 0x70, 0x65, },
+    { 0xa6, 0x49, 0x89, 0xc2, 0xd1, 0x80, 0xf2, 0x24, },
+    { 0x6b, 0x87, 0xf8, 0xfa, 0xed, 0x1c, 0xca, 0xc2, },
+    { 0x96, 0x21, 0x04, 0x9f, 0xfc, 0x4b, 0x16, 0xc2, },
+    { 0x23, 0xd6, 0xb1, 0x68, 0x93, 0x9c, 0x6e, 0xa1, },
+    { 0xfd, 0x14, 0x51, 0x8b, 0x9c, 0x16, 0xfb, 0x49, },
+    { 0x46, 0x4c, 0x07, 0xdf, 0xf8, 0x43, 0x31, 0x9f, },
+    { 0xb3, 0x86, 0xcc, 0x12, 0x24, 0xaf, 0xfd, 0xc6, },
+    { 0x8f, 0x09, 0x52, 0x0a, 0xd1, 0x49, 0xaf, 0x7e, },
+    { 0x9a, 0x2f, 0x29, 0x9d, 0x55, 0x13, 0xf3, 0x1c, },
+    { 0x12, 0x1f, 0xf4, 0xa2, 0xdd, 0x30, 0x4a, 0xc4, },
+    { 0xd0, 0x1e, 0xa7, 0x43, 0x89, 0xe9, 0xfa, 0x36, },
+    { 0xe6, 0xbc, 0xf0, 0x73, 0x4c, 0xb3, 0x8f, 0x31, },
+    { 0x80, 0xe9, 0xa7, 0x70, 0x36, 0xbf, 0x7a, 0xa2, },
+    { 0x75, 0x6d, 0x3c, 0x24, 0xdb, 0xc0, 0xbc, 0xb4, },
+    { 0x13, 0x15, 0xb7, 0xfd, 0x52, 0xd8, 0xf8, 0x23, },
+    { 0x08, 0x8a, 0x7d, 0xa6, 0x4d, 0x5f, 0x03, 0x8f, },
+    { 0x48, 0xf1, 0xe8, 0xb7, 0xe5, 0xd0, 0x9c, 0xd8, },
+    { 0xee, 0x44, 0xa6, 0xf7, 0xbc, 0xe6, 0xf4, 0xf6, },
+    { 0xf2, 0x37, 0x18, 0x0f, 0xd8, 0x9a, 0xc5, 0xae, },
+    { 0xe0, 0x94, 0x66, 0x4b, 0x15, 0xf6, 0xb2, 0xc3, },
+    { 0xa8, 0xb3, 0xbb, 0xb7, 0x62, 0x90, 0x19, 0x9d, }
+};
+
+/*
+   SipHash-4-8 output with the same key and inputs
+*/
+uint8_t vectors48[64][8] =
+{
+    { 0x41, 0xda, 0x38, 0x99, 0x2b, 0x05, 0x79, 0xc8, },
+    { 0x51, 0xb8, 0x95, 0x52, 0xf9, 0x14, 0x59, 0xc8, },
+    { 0x92, 0x37, 0x16, 0xf0, 0xbe, 0xdd, 0xc3, 0x33, },
+    { 0x6a, 0x46, 0xd4, 0x7d, 0x65, 0x47, 0xc1, 0x05, },
+    { 0xc2, 0x38, 0x59, 0x2b, 0x4a, 0xc1, 0xfa, 0x48, },
+    { 0xf6, 0xc2, 0xd7, 0xd9, 0xcf, 0x52, 0x47, 0xe1, },
+    { 0x6b, 0xb6, 0xbc, 0x34, 0xc8, 0x35, 0x55, 0x8e, },
+    { 0x47, 0xd7, 0x3f, 0x71, 0x5a, 0xbe, 0xfd, 0x4e, },
+    { 0x20, 0xb5, 0x8b, 0x9c, 0x07, 0x2f, 0xdb, 0x50, },
+    { 0x36, 0x31, 0x9a, 0xf3, 0x5e, 0xe1, 0x12, 0x53, },
+    { 0x48, 0xa9, 0xd0, 0xdb, 0x0a, 0x8d, 0x84, 0x8f, },
+    { 0xcc, 0x69, 0x39, 0x60, 0x36, 0x04, 0x0a, 0x81, },
+    { 0x4b, 0x6d, 0x68, 0x53, 0x7a, 0xa7, 0x97, 0x61, },
+    { 0x29, 0x37, 0x96, 0xe9, 0xf2, 0xc9, 0x50, 0x69, },
+    { 0x88, 0x43, 0x1b, 0xea, 0xa7, 0x62, 0x9a, 0x68, },
+    { 0xe0, 0xa6, 0xa9, 0x7d, 0xd5, 0x89, 0xd3, 0x83, },
+    { 0x55, 0x9c, 0xf5, 0x53, 0x80, 0xb2, 0xac, 0x70, },
+    { 0xd5, 0xb7, 0xc5, 0x11, 0x7a, 0xe3, 0x79, 0x4e, },
+    { 0x5a, 0x3c, 0x45, 0x46, 0x34, 0xad, 0x10, 0x2b, },
+    { 0xc0, 0xa4, 0x80, 0xaf, 0xa3, 0x5a, 0x3d, 0xbc, },
+    { 0x78, 0xc2, 0x27, 0x09, 0xe5, 0x28, 0x4b, 0xc8, },
+    { 0xef, 0x26, 0x70, 0x46, 0x0d, 0xeb, 0xd6, 0x9d, },
+    { 0xd9, 0x76, 0xef, 0x86, 0xa9, 0xd0, 0x84, 0xd8, },
+    { 0xe3, 0xd9, 0x81, 0x18, 0x19, 0xea, 0xd0, 0xe8, },
+    { 0x89, 0x33, 0x3c, 0xb5, 0x3e, 0xea, 0xec, 0x16, },
+    { 0x31, 0x15, 0x6c, 0x5f, 0x64, 0x73, 0x49, 0xc6, },
+    { 0xa5, 0x4c, 0xce, 0x35, 0x35, 0x76, 0x32, 0xa4, },
+    { 0x06, 0x5d, 0x89, 0x25, 0xc0, 0xa7, 0xd2, 0xfe, },
+    { 0x2b, 0xbb, 0xaa, 0x82, 0x22, 0x1a, 0x3a, 0x8b, },
+    { 0x87, 0x0b, 0xfb, 0xce, 0x64, 0x09, 0x7b, 0x70, },
+    { 0x40, 0xd8, 0xe0, 0xf9, 0x64, 0x95, 0xee, 0x8b, },
+    { 0x79, 0xfc, 0xa7, 0xf4, 0x0b, 0xfa, 0xdf, 0x12, },
+    { 0x00, 0x0b, 0xfb, 0xf2, 0x2f, 0x76, 0x9e, 0xd2, },
+    { 0x40, 0x68, 0x55, 0x91, 0xf8, 0xe5, 0x22, 0xfa, },
+    { 0x2b, 0xe6, 0xfe, 0x74, 0xd8, 0x14, 0x9d, 0x0d, },
+    { 0xba, 0x7e, 0x2f, 0x0e, 0x0b, 0x75, 0x60, 0xed, },
+    { 0x02, 0xe9, 0xe3, 0x84, 0xed, 0xa7, 0xe1, 0x97, },
+    { 0xc4, 0xe8, 0x0a, 0x62, 0x95, 0x27, 0x63, 0xb6, },
+    { 0x83, 0x27, 0xed, 0xc6, 0x5d, 0x5c, 0x6d, 0xd3, },
+    { 0x79, 0xfc, 0x64, 0xd1, 0x64, 0xa4, 0x2f, 0xc0, },
+    { 0x15, 0x4a, 0x75, 0x11, 0xcb, 0xfc, 0x61, 0x4e, },
+    { 0x8b, 0x14, 0x8d, 0x7c, 0xec, 0xa0, 0xe6, 0x6f, },
+    { 0xdf, 0xee, 0x69, 0xb6, 0x54, 0xc4, 0x03, 0xfa, },
+    { 0xc5, 0x8f, 0x36, 0xa6, 0x69, 0x7b, 0xb7, 0xc9, },
+    { 0xa6, 0xc5, 0xbe, 0x9c, 0x05, 0xc6, 0x31, 0x21, },
+    { 0xb5, 0x8a, 0x87, 0x59, 0xfb, 0xcd, 0x89, 0x31, },
+    { 0xd7, 0x68, 0x3a, 0x67, 0x04, 0xcc, 0xc4, 0x25, },
+    { 0xcb, 0x6a, 0xe6, 0xe1, 0xe5, 0xa2, 0x44, 0x8d, },
+    { 0x6e, 0x26, 0x69, 0x5b, 0x3a, 0x3a, 0x51, 0x73, },
+    { 0x78, 0x71, 0x07, 0xcf, 0x9f, 0x33, 0xac, 0x4a, },
+    { 0x16, 0x75, 0x90, 0xda, 0xd9, 0x7b, 0x74, 0x84, },
+    { 0x00, 0x6b, 0x68, 0x1e, 0xf0, 0x6b, 0xf3, 0x06, },
+    { 0x1c, 0x9b, 0x30, 0x02, 0x66, 0xef, 0xcf, 0xa6, },
+    { 0x28, 0x8d, 0x2f, 0x88, 0xd1, 0xb0, 0xb3, 0x4b, },
+    { 0xe0, 0x11, 0x06, 0xbd, 0xac, 0xf5, 0x6b, 0xfe, },
+    { 0xc0, 0x10, 0x1f, 0x0e, 0x5b, 0x6e, 0x03, 0x28, },
+    { 0xc3, 0xa7, 0x91, 0x45, 0x5b, 0x1b, 0x1c, 0x0a, },
+    { 0x57, 0x07, 0xaf, 0xe1, 0x9e, 0x0b, 0x3a, 0x0f, },
+    { 0xe6, 0x5a, 0x72, 0x29, 0xfe, 0x53, 0x59, 0x4f, },
+    { 0x00, 0x2f, 0x9d, 0xb9, 0xab, 0x1a, 0xaf, 0x4c, },
+    { 0x59, 0x28, 0xcb, 0x50, 0x44, 0xc1, 0x06, 0x06, },
+    { 0xd5, 0x38, 0x01, 0x96, 0x7b, 0x85, 0x73, 0x21, },
+    { 0x05, 0xdb, 0x36, 0x4f, 0x1a, 0x09, 0x99, 0xcc, },
+    { 0xe6, 0x77, 0x84, 0xbc, 0x55, 0x03, 0xde, 0x23, }
+};
+
+void hexdump(const uint8_t * data, const size_t len) {
+    unsigned int i;
+    for (i = 0; i < len; i++)
+        printf("0x%02x ",data[i]);
+    printf("\n");
+}
+
+int test_vectors(const char *name, hash_fn fn, hash_with_key_fn fn_with_key, uint8_t vectors[64][8]) {
+
+    uint8_t in[MAXLEN], out[8], k[16];
+    siphash_key_t prepared;
+    int i;
+    int ok = 1;
+
+    for(i = 0; i < 16; ++i) k[i] = i;
+    
+    siphash_key_init(&prepared, k);
+
+    for(i = 0; i < MAXLEN; ++i) {
+        in[i] = i;
+        
+        fn(out, in, (size_t) i, k);
+        
+        if (memcmp(out, vectors[i], 8)) {
+            printf("%s test vector failed for %d bytes\n", name, i);
+            printf("Expected:\t"); hexdump(vectors[i], 8);
+            printf("Got:\t\t"); hexdump(out, 8);
+            ok = 0;
+        }
+        
+        fn_with_key(out, in, (size_t) i, &prepared);
+        
+        if (memcmp(out, vectors[i], 8)) {
+            printf("%s prepared key test vector failed for %d bytes\n", name, i);
+            printf("Expected:\t"); hexdump(vectors[i], 8);
+            printf("Got:\t\t"); hexdump(out, 8);
+            ok = 0;
+        }
+    }
+
+    return ok;
+    
+}
+
+int main() {
+    
+    int ok = test_vectors("SipHash-1-3", siphash13, siphash13_with_key, vectors13);
+    ok &= test_vectors("SipHash-4-8", siphash48, siphash48_with_key, vectors48);
+    if (ok) printf("round variants test vectors ok (%d-bit backend)\n", MSH_BACKEND);
+
+    return !ok;
+
+}
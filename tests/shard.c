@@ -0,0 +1,225 @@
+/*
+ * shard.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Test the balance of the shard routing and the movement of items when nodes are added or removed
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include "shard.h"
+
+#define ITEMS 50000
+#define ITEM_LEN 8
+#define NODES 16
+#define MAX_NODES 64
+
+/* Allowed deviation of the load of any node from the mean, and of the moved share, in percent. */
+#define TOLERANCE 10
+
+static const struct {
+    uint64_t h;
+    int32_t buckets, expected;
+} jump_vectors[] = {
+    {UINT64_C(0x0000000000000000), 1, 0},
+    {UINT64_C(0x0000000000000001), 10, 6},
+    {UINT64_C(0x00000000deadbeef), 100, 87},
+    {UINT64_C(0x0123456789abcdef), 1000, 194},
+    {UINT64_C(0xffffffffffffffff), 4096, 1921},
+    {UINT64_C(0x002bdc545d6b4b87), 65536, 46958}
+};
+
+static uint8_t items[ITEMS][ITEM_LEN];
+static uint64_t before[ITEMS], after[ITEMS];
+
+/*
+ * Check that no node of the nodes got more or less than its share of the items, give or take the
+ * tolerance.
+ */
+static int balanced(const char *name, const uint64_t *assigned, const size_t nodes) {
+    
+    unsigned long load[MAX_NODES];
+    unsigned long mean = ITEMS / nodes;
+    size_t i;
+    
+    memset(load, 0, sizeof(load));
+    for (i = 0; i < ITEMS; i++) load[assigned[i]]++;
+    
+    for (i = 0; i < nodes; i++) {
+        if (load[i] * 100 > mean * (100 + TOLERANCE) || load[i] * 100 < mean * (100 - TOLERANCE)) {
+            printf("%s: node %lu got %lu items, %lu expected\n", name, (unsigned long) i, load[i], mean);
+            return 0;
+        }
+    }
+    
+    return 1;
+    
+}
+
+/*
+ * Check that only the expected share of the items moved, and all of them from or to the node.
+ */
+static int moved(const char *name, const uint64_t node, const size_t share, const int added) {
+    
+    unsigned long count = 0, expected = ITEMS / share;
+    size_t i;
+    
+    for (i = 0; i < ITEMS; i++) {
+        if (before[i] == after[i]) continue;
+        count++;
+        if ((added && after[i] != node) || (!added && before[i] != node)) {
+            printf("%s: item %lu moved from %lu to %lu\n", name, (unsigned long) i,
+                (unsigned long) before[i], (unsigned long) after[i]);
+            return 0;
+        }
+    }
+    
+    if (count * 100 > expected * (100 + TOLERANCE) || count * 100 < expected * (100 - TOLERANCE)) {
+        printf("%s: %lu items moved, %lu expected\n", name, count, expected);
+        return 0;
+    }
+    
+    return 1;
+    
+}
+
+int test_jump(const uint8_t *k) {
+    
+    siphash_key_t key;
+    size_t i;
+    int ok = 1;
+    
+    for (i = 0; i < sizeof(jump_vectors) / sizeof(jump_vectors[0]); i++) {
+        if (msh_jump_hash(jump_vectors[i].h, jump_vectors[i].buckets) != jump_vectors[i].expected) {
+            printf("jump hash vector %lu failed\n", (unsigned long) i);
+            ok = 0;
+        }
+    }
+    
+    siphash_key_init(&key, k);
+    
+    for (i = 0; i < ITEMS; i++) before[i] = (uint64_t) msh_jump(items[i], ITEM_LEN, &key, NODES);
+    ok &= balanced("jump", before, NODES);
+    
+    /* One more bucket takes its share from all the others. */
+    for (i = 0; i < ITEMS; i++) after[i] = (uint64_t) msh_jump(items[i], ITEM_LEN, &key, NODES + 1);
+    ok &= balanced("jump grown", after, NODES + 1);
+    ok &= moved("jump grown", NODES, NODES + 1, 1);
+    
+    /* And gives it back when removed. */
+    for (i = 0; i < ITEMS; i++) before[i] = after[i];
+    for (i = 0; i < ITEMS; i++) after[i] = (uint64_t) msh_jump(items[i], ITEM_LEN, &key, NODES);
+    ok &= moved("jump shrunk", NODES, NODES + 1, 0);
+    
+    return ok;
+    
+}
+
+int test_hrw(const uint8_t *k) {
+    
+    msh_hrw hrw, other;
+    uint64_t id;
+    unsigned long same = 0;
+    size_t i;
+    int ok = 1;
+    
+    msh_hrw_init(&hrw, k);
+    
+    if (msh_hrw_route(&hrw, items[0], ITEM_LEN, &id) != -1) {
+        printf("hrw routed to an empty set of nodes\n");
+        ok = 0;
+    }
+    
+    for (i = 0; i < NODES; i++) msh_hrw_add(&hrw, (uint64_t) i);
+    if (msh_hrw_add(&hrw, 0) != -1) {
+        printf("hrw added a node twice\n");
+        ok = 0;
+    }
+    
+    for (i = 0; i < ITEMS; i++) msh_hrw_route(&hrw, items[i], ITEM_LEN, &before[i]);
+    ok &= balanced("hrw", before, NODES);
+    
+    /* A new node wins its share of the items. */
+    msh_hrw_add(&hrw, NODES);
+    for (i = 0; i < ITEMS; i++) msh_hrw_route(&hrw, items[i], ITEM_LEN, &after[i]);
+    ok &= balanced("hrw added", after, NODES + 1);
+    ok &= moved("hrw added", NODES, NODES + 1, 1);
+    
+    /* Only the items of a removed node move, whichever it is. */
+    for (i = 0; i < ITEMS; i++) before[i] = after[i];
+    msh_hrw_remove(&hrw, 3);
+    for (i = 0; i < ITEMS; i++) msh_hrw_route(&hrw, items[i], ITEM_LEN, &after[i]);
+    ok &= moved("hrw removed", 3, NODES + 1, 0);
+    
+    /* Adding it back restores the original routing. */
+    msh_hrw_add(&hrw, 3);
+    for (i = 0; i < ITEMS; i++) {
+        msh_hrw_route(&hrw, items[i], ITEM_LEN, &id);
+        if (id != before[i]) {
+            printf("hrw routing not restored for item %lu\n", (unsigned long) i);
+            ok = 0;
+            break;
+        }
+    }
+    
+    /* Under another key, items are routed independently. */
+    msh_hrw_init(&other, k + 16);
+    for (i = 0; i <= NODES; i++) msh_hrw_add(&other, (uint64_t) i);
+    for (i = 0; i < ITEMS; i++) {
+        msh_hrw_route(&other, items[i], ITEM_LEN, &id);
+        same += id == before[i];
+    }
+    if (same * (NODES + 1) > ITEMS * 2) {
+        printf("hrw routing under another key matches for %lu items\n", same);
+        ok = 0;
+    }
+    
+    msh_hrw_free(&hrw);
+    msh_hrw_free(&other);
+    
+    return ok;
+    
+}
+
+int main() {
+    
+    uint8_t k[32];
+    size_t i, j;
+    int ok;
+    
+    srand(1);
+    
+    for (i = 0; i < sizeof(k); i++) k[i] = (uint8_t) rand();
+    for (i = 0; i < ITEMS; i++) {
+        for (j = 0; j < ITEM_LEN; j++) items[i][j] = (uint8_t) rand();
+    }
+    
+    ok = test_jump(k);
+    ok &= test_hrw(k);
+    if (ok) printf("shard ok (%d-bit backend)\n", MSH_BACKEND);
+    
+    return !ok;
+    
+}
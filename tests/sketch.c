@@ -0,0 +1,191 @@
+/*
+ * sketch.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Test the keyed Bloom filter and count-min sketch
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include "sketch.h"
+
+#define ITEMS 10000
+#define NON_MEMBERS 100000
+#define ITEM_LEN 8
+#define BITS_PER_ITEM 10
+#define STREAM 200000
+#define COUNTERS 16384
+
+static uint8_t items[ITEMS][ITEM_LEN];
+static const uint8_t *item_ptrs[ITEMS];
+static size_t item_lens[ITEMS];
+static uint8_t results[ITEMS];
+static uint32_t counts[ITEMS], estimates[ITEMS];
+
+/* Deterministic random source, so the test is reproducible. */
+static int test_random(uint8_t *buf, const size_t len) {
+    size_t i;
+    for (i = 0; i < len; i++) buf[i] = (uint8_t) rand();
+    return 0;
+}
+
+/* Item i, distinct for every i, non-members being numbered from ITEMS on. */
+static void make_item(uint8_t *item, const unsigned long i) {
+    int j;
+    for (j = 0; j < ITEM_LEN; j++) item[j] = (uint8_t) (i >> (8 * (j % 4)));
+    item[ITEM_LEN - 1] ^= 0x5a;
+}
+
+int test_bloom() {
+    
+    msh_bloom bloom, other;
+    uint8_t item[ITEM_LEN];
+    unsigned long i, false_positives = 0;
+    double fpr;
+    int ok = 1;
+    
+    if (msh_bloom_init(&bloom, ITEMS, BITS_PER_ITEM, test_random)) {
+        printf("bloom init failed\n");
+        return 0;
+    }
+    
+    /* Half the items one by one, the other half at once. */
+    for (i = 0; i < ITEMS / 2; i++) msh_bloom_add(&bloom, items[i], ITEM_LEN);
+    msh_bloom_add_batch(&bloom, item_ptrs + ITEMS / 2, item_lens, ITEMS - ITEMS / 2);
+    
+    msh_bloom_query_batch(&bloom, item_ptrs, item_lens, ITEMS, results);
+    for (i = 0; i < ITEMS; i++) {
+        if (!results[i] || !msh_bloom_query(&bloom, items[i], ITEM_LEN)) {
+            printf("bloom false negative for item %lu\n", i);
+            ok = 0;
+            break;
+        }
+    }
+    
+    for (i = 0; i < NON_MEMBERS; i++) {
+        make_item(item, ITEMS + i);
+        false_positives += (unsigned long) msh_bloom_query(&bloom, item, ITEM_LEN);
+    }
+    
+    /* A standard filter of 10 bits per item gives about 0.8%, blocking costs a little of that. */
+    fpr = (double) false_positives / NON_MEMBERS;
+    if (fpr > 0.02) {
+        printf("bloom false positive rate %.4f too high\n", fpr);
+        ok = 0;
+    }
+    
+    /* The same items under another key set other bits. */
+    msh_bloom_init(&other, ITEMS, BITS_PER_ITEM, test_random);
+    msh_bloom_add_batch(&other, item_ptrs, item_lens, ITEMS);
+    if (!memcmp(bloom.blocks, other.blocks, (bloom.block_mask + 1) * MSH_SKETCH_LINE)) {
+        printf("bloom filters under different keys are equal\n");
+        ok = 0;
+    }
+    
+    msh_bloom_free(&bloom);
+    msh_bloom_free(&other);
+    
+    return ok;
+    
+}
+
+int test_cms() {
+    
+    msh_cms cms;
+    unsigned long i, idx, over = 0;
+    int ok = 1;
+    
+    if (msh_cms_init(&cms, COUNTERS, 4, test_random)) {
+        printf("cms init failed\n");
+        return 0;
+    }
+    
+    memset(counts, 0, sizeof(counts));
+    
+    /* Skewed stream, low indices being the heavy hitters. */
+    for (i = 0; i < STREAM; i++) {
+        idx = (unsigned long) rand() % ITEMS;
+        idx = idx * ((unsigned long) rand() % ITEMS) / ITEMS;
+        counts[idx]++;
+        if (i % 2) msh_cms_add(&cms, items[idx], ITEM_LEN, 1);
+        else msh_cms_add_batch(&cms, item_ptrs + idx, item_lens, NULL, 1);
+    }
+    
+    msh_cms_estimate_batch(&cms, item_ptrs, item_lens, ITEMS, estimates);
+    for (i = 0; i < ITEMS; i++) {
+        if (estimates[i] != msh_cms_estimate(&cms, items[i], ITEM_LEN)) {
+            printf("cms batch estimate differs for item %lu\n", i);
+            ok = 0;
+            break;
+        }
+        if (estimates[i] < counts[i]) {
+            printf("cms underestimates item %lu: %lu < %lu\n", i, (unsigned long) estimates[i],
+                (unsigned long) counts[i]);
+            ok = 0;
+            break;
+        }
+        over += estimates[i] - counts[i];
+    }
+    
+    /* The overestimate is bounded by the total count over the width of a row, on average. */
+    if (over / ITEMS > STREAM / (COUNTERS / 4)) {
+        printf("cms mean overestimate %lu too high\n", over / ITEMS);
+        ok = 0;
+    }
+    
+    /* Counters saturate. */
+    msh_cms_add(&cms, items[0], ITEM_LEN, 0xffffffffUL);
+    msh_cms_add(&cms, items[0], ITEM_LEN, 0xffffffffUL);
+    if (msh_cms_estimate(&cms, items[0], ITEM_LEN) != 0xffffffffUL) {
+        printf("cms counter wrapped around\n");
+        ok = 0;
+    }
+    
+    msh_cms_free(&cms);
+    
+    return ok;
+    
+}
+
+int main() {
+    
+    unsigned long i;
+    int ok;
+    
+    srand(1);
+    
+    for (i = 0; i < ITEMS; i++) {
+        make_item(items[i], i);
+        item_ptrs[i] = items[i];
+        item_lens[i] = ITEM_LEN;
+    }
+    
+    ok = test_bloom();
+    ok &= test_cms();
+    if (ok) printf("sketch ok (%d-bit backend)\n", MSH_BACKEND);
+    
+    return !ok;
+    
+}
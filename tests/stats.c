@@ -0,0 +1,225 @@
+/*
+ * stats.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Test the instrumentation counters against the calls, bytes and rounds every entry point shall
+ * account, and that they are kept per thread. Shall be built with MSH_INSTRUMENT defined.
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+#include "siphash.h"
+
+#ifndef MSH_INSTRUMENT
+#error "The test shall be built with MSH_INSTRUMENT defined"
+#endif
+
+static const size_t lengths[] = {0, 1, 7, 8, 15, 16, 63, 64, 100, 1000};
+#define LENGTHS (sizeof(lengths) / sizeof(lengths[0]))
+
+static uint8_t data[1000], key[16], hash[16];
+static siphash_key_t prepared;
+static siphash_stats expected;
+
+static unsigned int bucket(size_t n) {
+    unsigned int b = 0;
+    for (; n; n >>= 1) b++;
+    return b;
+}
+
+/* Expect a one-shot hash of len bytes with the given compression and finalization rounds. */
+static void account(const size_t len, const unsigned long compress, const unsigned long final) {
+    expected.calls++;
+    expected.bytes += (unsigned long) len;
+    expected.compress_rounds += compress;
+    expected.final_rounds += final;
+    expected.length[bucket(len)]++;
+}
+
+static int check(const char *name) {
+    
+    siphash_stats stats;
+    unsigned long hashes = 0;
+    int i, ok = 1;
+    
+    siphash_stats_snapshot(&stats);
+    
+    if (stats.calls != expected.calls || stats.streams != expected.streams ||
+        stats.bytes != expected.bytes || stats.compress_rounds != expected.compress_rounds ||
+        stats.final_rounds != expected.final_rounds) ok = 0;
+    for (i = 0; i < SIPHASH_STATS_BUCKETS; i++) {
+        if (stats.length[i] != expected.length[i]) ok = 0;
+        hashes += stats.latency[i];
+    }
+    
+#ifdef MSH_INSTRUMENT_TSC
+    if (hashes != stats.calls - stats.streams || (hashes && !stats.cycles)) ok = 0;
+#else
+    if (hashes || stats.cycles) ok = 0;
+#endif
+    
+    if (!ok) {
+        printf("%s: calls %lu/%lu, streams %lu/%lu, bytes %lu/%lu, rounds %lu/%lu + %lu/%lu, "
+            "latency %lu\n", name, stats.calls, expected.calls, stats.streams, expected.streams,
+            stats.bytes, expected.bytes, stats.compress_rounds, expected.compress_rounds,
+            stats.final_rounds, expected.final_rounds, hashes);
+    }
+    
+    return ok;
+    
+}
+
+static int test_oneshot(void) {
+    
+    size_t i;
+    unsigned long blocks;
+    int ok = 1;
+    
+    for (i = 0; i < LENGTHS; i++) {
+        blocks = (unsigned long) lengths[i] / 8 + 1;
+        siphash(hash, data, lengths[i], key);
+        account(lengths[i], 2 * blocks, 4);
+        siphash13_with_key(hash, data, lengths[i], &prepared);
+        account(lengths[i], blocks, 3);
+        siphash48(hash, data, lengths[i], key);
+        account(lengths[i], 4 * blocks, 8);
+        siphash128_with_key(hash, data, lengths[i], &prepared);
+        account(lengths[i], 2 * blocks, 8);
+    }
+    ok &= check("one-shot");
+    
+    siphash_u32(hash, data, &prepared);
+    account(4, 2, 4);
+    siphash_u64(hash, data, &prepared);
+    account(8, 4, 4);
+    siphash_u128(hash, data, &prepared);
+    account(16, 6, 4);
+    ok &= check("fixed length");
+    
+    return ok;
+    
+}
+
+static int test_streaming(void) {
+    
+    siphash_ctx ctx;
+    size_t i;
+    
+    siphash_init(&ctx, key);
+    for (i = 0; i < 100; i += 10) siphash_update(&ctx, data + i, 10);
+    siphash_final(&ctx, hash);
+    
+    expected.calls++;
+    expected.streams++;
+    expected.bytes += 100;
+    expected.compress_rounds += 2 * (100 / 8 + 1);
+    expected.final_rounds += 4;
+    
+    return check("streaming");
+    
+}
+
+#ifdef MSH_HAVE_IOVEC
+static int test_iovec(void) {
+    
+    struct iovec iov[3];
+    
+    iov[0].iov_base = data;
+    iov[0].iov_len = 3;
+    iov[1].iov_base = data + 3;
+    iov[1].iov_len = 0;
+    iov[2].iov_base = data + 3;
+    iov[2].iov_len = 30;
+    siphash_v(hash, iov, 3, key);
+    account(33, 2 * (33 / 8 + 1), 4);
+    
+    return check("scatter-gather");
+    
+}
+#endif
+
+static void *hash_elsewhere(void *arg) {
+    
+    siphash_stats *stats = (siphash_stats *) arg;
+    
+    siphash_stats_reset();
+    siphash(hash, data, 20, key);
+    siphash_stats_snapshot(stats);
+    
+    return NULL;
+    
+}
+
+/*
+ * Hashes computed by another thread don't show up in the counters of this one.
+ */
+static int test_threads(void) {
+    
+    siphash_stats other;
+    pthread_t thread;
+    int ok = 1;
+    
+    if (pthread_create(&thread, NULL, hash_elsewhere, &other)) return 0;
+    pthread_join(thread, NULL);
+    
+    if (other.calls != 1 || other.bytes != 20) {
+        printf("threads: calls %lu, bytes %lu in the other thread\n", other.calls, other.bytes);
+        ok = 0;
+    }
+    
+    return ok & check("threads");
+    
+}
+
+static int test_reset(void) {
+    siphash_stats_reset();
+    memset(&expected, 0, sizeof(expected));
+    return check("reset");
+}
+
+int main() {
+    
+    int ok = 1;
+    size_t i;
+    
+    for (i = 0; i < sizeof(data); i++) data[i] = (uint8_t) i;
+    for (i = 0; i < sizeof(key); i++) key[i] = (uint8_t) i;
+    siphash_key_init(&prepared, key);
+    
+    ok &= test_reset();
+    ok &= test_oneshot();
+    ok &= test_streaming();
+#ifdef MSH_HAVE_IOVEC
+    ok &= test_iovec();
+#endif
+    ok &= test_threads();
+    ok &= test_reset();
+    
+    if (ok) printf("stats ok (%d-bit backend)\n", MSH_BACKEND);
+    
+    return !ok;
+    
+}
@@ -0,0 +1,120 @@
+/*
+ * streaming.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Test the incremental interface against the one-shot siphash()
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "siphash.h"
+#define MAXLEN 600
+#define SPLITS 20
+
+void hexdump(const uint8_t * data, const size_t len) {
+    unsigned int i;
+    for (i = 0; i < len; i++)
+        printf("0x%02x ",data[i]);
+    printf("\n");
+}
+
+/*
+ * Hash the message in chunks of random lengths, including empty ones.
+ */
+void hash_chunked(uint8_t *hash, const uint8_t *data, const size_t len, const uint8_t *key) {
+    
+    siphash_ctx ctx;
+    size_t offset = 0, chunk;
+    
+    siphash_init(&ctx, key);
+    
+    while (offset < len) {
+        chunk = (size_t) rand() % 20;
+        if (chunk > len - offset) chunk = len - offset;
+        siphash_update(&ctx, data + offset, chunk);
+        offset += chunk;
+    }
+    
+    siphash_final(&ctx, hash);
+    
+}
+
+int test_splits() {
+    
+    uint8_t in[MAXLEN], expected[8], out[8], k[16];
+    siphash_ctx ctx;
+    int i, j;
+    int ok = 1;
+    
+    srand(1);
+    
+    for (i = 0; i < 16; i++) k[i] = (uint8_t) rand();
+    for (i = 0; i < MAXLEN; i++) in[i] = (uint8_t) rand();
+    
+    for (i = 0; i < MAXLEN; i++) {
+        
+        siphash(expected, in, (size_t) i, k);
+        
+        /* Whole message in a single update. */
+        siphash_init(&ctx, k);
+        siphash_update(&ctx, in, (size_t) i);
+        siphash_final(&ctx, out);
+        
+        if (memcmp(out, expected, 8)) {
+            printf("single update failed for %d bytes\n", i);
+            printf("Expected:\t"); hexdump(expected, 8);
+            printf("Got:\t\t"); hexdump(out, 8);
+            ok = 0;
+        }
+        
+        for (j = 0; j < SPLITS; j++) {
+            
+            hash_chunked(out, in, (size_t) i, k);
+            
+            if (memcmp(out, expected, 8)) {
+                printf("chunked update failed for %d bytes\n", i);
+                printf("Expected:\t"); hexdump(expected, 8);
+                printf("Got:\t\t"); hexdump(out, 8);
+                ok = 0;
+                break;
+            }
+            
+        }
+        
+    }
+    
+    return ok;
+    
+}
+
+int main() {
+    
+    int ok = test_splits();
+    if (ok) printf("streaming ok (%d-bit backend)\n", MSH_BACKEND);
+    
+    return !ok;
+    
+}
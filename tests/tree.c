@@ -0,0 +1,103 @@
+/*
+ * tree.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Test the tree hash mode of extras/tree against its test vectors, serially and on a thread pool
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "siphash_tree.h"
+
+#define MAXLEN 1100000
+#define THREADS 4
+
+/*
+ * siphash-tree v1 of the bytes i % 251 under the key 00 01 .. 0f, generated with an independent
+ * implementation of the construction described in extras/tree/README.md.
+ */
+static const struct {
+    size_t len;
+    size_t leaf_size;
+    uint8_t hash[8];
+} vectors[] = {
+    {      0,  1024, {0x0c, 0x24, 0x77, 0x5b, 0xcf, 0x57, 0x9e, 0x19}},
+    {      1,  1024, {0xc9, 0xac, 0x7b, 0x60, 0x43, 0xb8, 0x3b, 0xe8}},
+    {   1023,  1024, {0x60, 0xc8, 0x96, 0x49, 0x80, 0x71, 0xe8, 0xec}},
+    {   1024,  1024, {0x5d, 0xd1, 0x97, 0xfb, 0x93, 0x4a, 0x89, 0x36}},
+    {   1025,  1024, {0x20, 0xe4, 0xc5, 0x50, 0x22, 0xe0, 0xca, 0xcb}},
+    {   4096,  1024, {0xee, 0xe8, 0xfc, 0x35, 0xab, 0x3f, 0xa0, 0x4f}},
+    {  10000,  1024, {0x79, 0x30, 0x21, 0x02, 0x41, 0x1f, 0x16, 0x47}},
+    {   1000,     1, {0xba, 0xe1, 0xb0, 0xfa, 0x3f, 0xd0, 0x72, 0x0a}},
+    { 200000, 65536, {0x78, 0xc0, 0x31, 0xfb, 0x15, 0xbf, 0xe4, 0x8b}},
+    {1100000,  1024, {0x0f, 0x69, 0xe5, 0x44, 0xb6, 0x21, 0x6d, 0x88}}
+};
+
+void hexdump(const uint8_t * data, const size_t len) {
+    unsigned int i;
+    for (i = 0; i < len; i++)
+        printf("0x%02x ",data[i]);
+    printf("\n");
+}
+
+int main() {
+    
+    static uint8_t data[MAXLEN];
+    uint8_t key[16], hash[8];
+    msh_pool pool;
+    size_t i;
+    int ok = 1, parallel;
+    
+    for (i = 0; i < sizeof(key); i++) key[i] = (uint8_t) i;
+    for (i = 0; i < MAXLEN; i++) data[i] = (uint8_t) (i % 251);
+    
+    if (msh_pool_init(&pool, THREADS)) return 1;
+    
+    for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        for (parallel = 0; parallel <= 1; parallel++) {
+            siphash_tree(hash, data, vectors[i].len, vectors[i].leaf_size, key, parallel ? &pool : NULL);
+            if (memcmp(hash, vectors[i].hash, 8)) {
+                printf("%s tree hash failed for %d bytes, %d byte leaves\n",
+                    parallel ? "parallel" : "serial", (int) vectors[i].len, (int) vectors[i].leaf_size);
+                printf("Expected:\t"); hexdump(vectors[i].hash, 8);
+                printf("Got:\t\t"); hexdump(hash, 8);
+                ok = 0;
+            }
+        }
+    }
+    
+    if (siphash_tree(hash, data, 1, 0, key, NULL) != -1) {
+        printf("zero leaf size not rejected\n");
+        ok = 0;
+    }
+    
+    msh_pool_free(&pool);
+    
+    if (ok) printf("tree hash ok (%d-bit backend)\n", MSH_BACKEND);
+    
+    return !ok;
+    
+}
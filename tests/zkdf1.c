@@ -0,0 +1,89 @@
+/*
+ * zkdf1.c
+ * SipHash implementation for compilers w/o 64 bit arithmetics
+ * Copyright (c) 2019 Michał Getka
+ * 
+ * Test zkdf1 against kdf1, and against plain SipHash of the counter blocks beyond the reach of the
+ * single byte counter of kdf1
+ * 
+ */
+
+/*  
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * 
+ */
+
+#include <stdio.h>
+#include "kdf1.h"
+#include "zkdf1.h"
+
+#define MAX_INFO 40
+#define LONG_BLOCKS 2100
+
+static const size_t lengths[] = {0, 1, 7, 8, 9, 31, 32, 33, 40, 63, 100, 512, 1000, 1023};
+
+static uint8_t key[16], info[MAX_INFO];
+static uint8_t expected[8 * LONG_BLOCKS], derived[8 * LONG_BLOCKS + 1];
+
+int main() {
+    
+    uint8_t block[4 + MAX_INFO];
+    size_t info_len, i;
+    int ok = 1;
+    
+    srand(1);
+    for (i = 0; i < sizeof(key); i++) key[i] = (uint8_t) rand();
+    for (i = 0; i < sizeof(info); i++) info[i] = (uint8_t) rand();
+    
+    for (info_len = 0; info_len <= MAX_INFO; info_len++) {
+        for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+            /* Guard byte past the derived key. */
+            derived[lengths[i]] = 0xa5;
+            if (kdf1(expected, lengths[i], info, info_len, key) ||
+                zkdf1(derived, lengths[i], info, info_len, key) ||
+                memcmp(expected, derived, lengths[i]) || derived[lengths[i]] != 0xa5) {
+                printf("mismatch with kdf1 for info of %d bytes, key of %d bytes\n", (int) info_len,
+                    (int) lengths[i]);
+                ok = 0;
+            }
+        }
+    }
+    
+    /* Counter blocks past the byte counter, BE32(i) || info. */
+    info_len = 13;
+    memcpy(block + 4, info, info_len);
+    for (i = 0; i < LONG_BLOCKS; i++) {
+        block[0] = (uint8_t) (i >> 24);
+        block[1] = (uint8_t) (i >> 16);
+        block[2] = (uint8_t) (i >> 8);
+        block[3] = (uint8_t) i;
+        siphash(expected + 8 * i, block, 4 + info_len, key);
+    }
+    
+    if (zkdf1(derived, sizeof(expected) - 3, info, info_len, key) ||
+        memcmp(expected, derived, sizeof(expected) - 3)) {
+        printf("mismatch for a long derived key\n");
+        ok = 0;
+    }
+    
+    if (ok) printf("zkdf1 ok (%d-bit backend)\n", MSH_BACKEND);
+    
+    return !ok;
+    
+}